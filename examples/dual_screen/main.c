@@ -5,6 +5,7 @@
 // For the full copyright and license information, please view the LICENSE
 // file that was distributed with this source code.
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,6 +27,15 @@
 	| GX_TRANSFER_SCALING(GX_TRANSFER_SCALE_NO)
 // clang-format on
 
+// Identifies the custom waveform element in the layout.
+static u8 waveformKey;
+
+static Clay3DS_Shadow buttonShadow = {
+  .color = {0, 0, 0, 160},
+  .blur = 6.f,
+  .offset = {0.f, 4.f},
+};
+
 void onButtonInteraction(Clay_ElementId element, Clay_PointerData pointer, intptr_t)
 {
   if (pointer.state == CLAY_POINTER_DATA_PRESSED_THIS_FRAME)
@@ -89,6 +99,12 @@ Clay_RenderCommandArray topLayout(void)
       ) {}
     }
 
+    // The waveform mesh is built once, and only stretched to the element's box on each frame.
+    CLAY(
+      CLAY_LAYOUT({.sizing = {.width = CLAY_SIZING_FIXED(240), .height = CLAY_SIZING_FIXED(40)}}),
+      CLAY_CUSTOM_ELEMENT({.customData = &waveformKey})
+    ) {}
+
     CLAY(
       CLAY_TEXT(
         CLAY_STRING("clay is not for the weak"),
@@ -117,29 +133,34 @@ Clay_RenderCommandArray bottomLayout(void)
       .childGap = 12
     })
   ) {
+    // The shadow is drawn by the wrapping element, before the button itself.
     CLAY(
-      CLAY_ID("EXIT_BUTTON"),
-      Clay_OnHover(onButtonInteraction, 0),
-      CLAY_RECTANGLE({
-        .color = Clay_Hovered()
-          ? (Clay_Color){50, 69, 103, 255}
-          : (Clay_Color){33, 46, 69, 255},
-      }),
-      CLAY_BORDER_OUTSIDE(1, (Clay_Color){152, 171, 205, 255}),
-      CLAY_LAYOUT({
-        .sizing = {.width = CLAY_SIZING_FIXED(160), .height = CLAY_SIZING_FIT()},
-        .padding = {.x = 12, .y = 6}
-      })
+      CLAY_CUSTOM_ELEMENT({.customData = &buttonShadow})
     ) {
       CLAY(
-        CLAY_TEXT(
-          CLAY_STRING("interactivity is preserved\n\nguess what happens if you press this big button"),
-          CLAY_TEXT_CONFIG({
-            .textColor = (Clay_Color){152, 171, 205, 255},
-            .fontSize = 16
-          })
-        )
-      ) {}
+        CLAY_ID("EXIT_BUTTON"),
+        Clay_OnHover(onButtonInteraction, 0),
+        CLAY_RECTANGLE({
+          .color = Clay_Hovered()
+            ? (Clay_Color){50, 69, 103, 255}
+            : (Clay_Color){33, 46, 69, 255},
+        }),
+        CLAY_BORDER_OUTSIDE(1, (Clay_Color){152, 171, 205, 255}),
+        CLAY_LAYOUT({
+          .sizing = {.width = CLAY_SIZING_FIXED(160), .height = CLAY_SIZING_FIT()},
+          .padding = {.x = 12, .y = 6}
+        })
+      ) {
+        CLAY(
+          CLAY_TEXT(
+            CLAY_STRING("interactivity is preserved\n\nguess what happens if you press this big button"),
+            CLAY_TEXT_CONFIG({
+              .textColor = (Clay_Color){152, 171, 205, 255},
+              .fontSize = 16
+            })
+          )
+        ) {}
+      }
     }
   }
 
@@ -147,6 +168,34 @@ Clay_RenderCommandArray bottomLayout(void)
   return Clay_EndLayout();
 }
 
+Clay3DS_Mesh* createWaveform(void)
+{
+  const u32 points = 256;
+  const float thickness = 2.f;
+  u32 color = C2D_Color32(0, 255, 255, 255);
+
+  Clay3DS_Mesh* mesh = Clay3DS_MeshCreate((float)(points - 1), 2.f, (points - 1) * 2);
+  if (mesh == NULL)
+  {
+    return NULL;
+  }
+
+  for (u32 i = 0; i + 1 < points; ++i)
+  {
+    float x1 = (float)i;
+    float x2 = (float)(i + 1);
+    float y1 = 1.f + sinf(x1 * 0.1f) * cosf(x1 * 0.013f) * 0.8f;
+    float y2 = 1.f + sinf(x2 * 0.1f) * cosf(x2 * 0.013f) * 0.8f;
+    // Half of the line thickness in mesh units, as the mesh is 2 units tall and drawn 40 pixels tall.
+    float h = thickness / 40.f;
+
+    Clay3DS_MeshAddTriangle(mesh, x1, y1 - h, color, x2, y2 - h, color, x2, y2 + h, color);
+    Clay3DS_MeshAddTriangle(mesh, x1, y1 - h, color, x2, y2 + h, color, x1, y1 + h, color);
+  }
+
+  return mesh;
+}
+
 void onClayError(Clay_ErrorData error)
 {
   fprintf(stderr, "error: %s\n", error.errorText.chars);
@@ -164,6 +213,12 @@ int main(void)
   C3D_Init(C3D_DEFAULT_CMDBUF_SIZE);
   C2D_Init(C2D_DEFAULT_MAX_OBJECTS);
   C2D_Prepare();
+  Clay3DS_SetVertexBudget(C2D_DEFAULT_MAX_OBJECTS);
+  Clay3DS_SetAntialiasing(true);
+
+  Clay3DS_Mesh* waveform = createWaveform();
+  Clay3DS_RegisterCustomHandler(&waveformKey, Clay3DS_MeshHandler, waveform);
+  Clay3DS_RegisterCustomHandler(&buttonShadow, Clay3DS_ShadowHandler, NULL);
 
   C3D_RenderTarget* top = C2D_CreateScreenTarget(GFX_TOP, GFX_LEFT);
   C3D_RenderTarget* bottom = C3D_RenderTargetCreate(240, 320, GPU_RB_RGBA8, GPU_RB_DEPTH24_STENCIL8);
@@ -173,6 +228,11 @@ int main(void)
   u32 clearColor = C2D_Color32(0, 0, 0, 255);
   u64 previousTime = osGetTime();
 
+  // The top screen has no interactive elements, so it is only rendered in the first frames and then kept on screen.
+  Clay3DS_FrameDriver driver;
+  Clay3DS_FrameDriverInit(&driver);
+  driver.keysScreens = Clay3DS_SCREEN_NONE;
+
   while (aptMainLoop())
   {
     u64 currentTime = osGetTime();
@@ -183,8 +243,6 @@ int main(void)
     // Update Input
     // ============================
 
-    Clay_UpdateScrollContainers(true, (Clay_Vector2){0.f, 0.f}, deltaTime);
-
     hidScanInput();
     bool isTouching = hidKeysHeld() & KEY_TOUCH;
     touchPosition touch;
@@ -203,33 +261,54 @@ int main(void)
     // Rendering
     // ============================
 
+    u32 screens = Clay3DS_FrameDriverUpdate(&driver);
+    if (screens == Clay3DS_SCREEN_NONE)
+    {
+      // Nothing changed, keep the last frames on screen.
+      gspWaitForVBlank();
+      continue;
+    }
+
+    // Scroll containers must only be updated in the frames that are laid out, or Clay forgets them.
+    Clay_UpdateScrollContainers(true, (Clay_Vector2){0.f, 0.f}, deltaTime);
+    Clay3DS_ShadowCacheUpdate();
+
     C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
+    Clay3DS_ResetVertexBudget();
 
     // ==================
     // Top Screen
     // ==================
 
-    C2D_TargetClear(top, clearColor);
-    C2D_SceneBegin(top);
+    if (screens & Clay3DS_SCREEN_TOP)
+    {
+      C2D_TargetClear(top, clearColor);
+      C2D_SceneBegin(top);
 
-    Clay_Dimensions dimensions = (Clay_Dimensions){400, 240};
-    Clay_SetLayoutDimensions(dimensions);
-    Clay3DS_Render(top, dimensions, topLayout());
+      Clay_Dimensions dimensions = (Clay_Dimensions){400, 240};
+      Clay_SetLayoutDimensions(dimensions);
+      Clay3DS_Render(top, dimensions, topLayout());
+    }
 
     // ==================
     // Bottom Screen
     // ==================
 
-    C2D_TargetClear(bottom, clearColor);
-    C2D_SceneBegin(bottom);
+    if (screens & Clay3DS_SCREEN_BOTTOM)
+    {
+      C2D_TargetClear(bottom, clearColor);
+      C2D_SceneBegin(bottom);
 
-    dimensions = (Clay_Dimensions){320, 240};
-    Clay_SetLayoutDimensions(dimensions);
-    Clay3DS_Render(bottom, dimensions, bottomLayout());
+      Clay_Dimensions dimensions = (Clay_Dimensions){320, 240};
+      Clay_SetLayoutDimensions(dimensions);
+      Clay3DS_Render(bottom, dimensions, bottomLayout());
+    }
 
     C3D_FrameEnd(0);
   }
 
+  Clay3DS_MeshDelete(waveform);
+
   C2D_Fini();
   C3D_Fini();
   gfxExit();
@@ -118,12 +118,20 @@ int main(void)
   C2D_Init(C2D_DEFAULT_MAX_OBJECTS);
   C2D_Prepare();
 
+  // Let the renderer know the size of the citro2d buffers, so that it never overflows them.
+  Clay3DS_SetVertexBudget(C2D_DEFAULT_MAX_OBJECTS);
+
   consoleInit(GFX_TOP, NULL);
   C3D_RenderTarget* bottom = C2D_CreateScreenTarget(GFX_BOTTOM, GFX_LEFT);
 
   u32 clearColor = C2D_Color32(0, 0, 0, 255);
   u64 previousTime = osGetTime();
 
+  // Only lay out and render the bottom screen when the input or the palette scroll position changes.
+  Clay3DS_FrameDriver driver;
+  Clay3DS_FrameDriverInit(&driver);
+  Clay3DS_FrameDriverWatchScroll(&driver, CLAY_ID("PALETTE_VIEW"), Clay3DS_SCREEN_BOTTOM);
+
   printf("want to learn more?\n");
   printf("github.com/sonodima/clay3ds\n");
 
@@ -137,8 +145,6 @@ int main(void)
     // Update Input
     // ============================
 
-    Clay_UpdateScrollContainers(true, (Clay_Vector2){0.f, 0.f}, deltaTime);
-
     hidScanInput();
     bool isTouching = hidKeysHeld() & KEY_TOUCH;
     touchPosition touch;
@@ -157,7 +163,18 @@ int main(void)
     // Rendering
     // ============================
 
+    if (!(Clay3DS_FrameDriverUpdate(&driver) & Clay3DS_SCREEN_BOTTOM))
+    {
+      // Nothing changed, keep the last frame on screen.
+      gspWaitForVBlank();
+      continue;
+    }
+
+    // Scroll containers must only be updated in the frames that are laid out, or Clay forgets them.
+    Clay_UpdateScrollContainers(true, (Clay_Vector2){0.f, 0.f}, deltaTime);
+
     C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
+    Clay3DS_ResetVertexBudget();
     C2D_TargetClear(bottom, clearColor);
     C2D_SceneBegin(bottom);
 
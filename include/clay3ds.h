@@ -12,6 +12,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 #include <3ds.h>
 #include <citro2d.h>
@@ -19,15 +22,133 @@
 
 #include "clay.h"
 
+// Feature switches. Defining any of the CLAY3DS_DISABLE_* macros before including this header strips the matching
+// render path (and the static data only used by it); render commands of a disabled type are silently skipped.
+#ifdef CLAY3DS_DISABLE_ROUNDED_CORNERS
+#define Clay3DSi__HAS_ROUNDED_CORNERS 0
+#else
+#define Clay3DSi__HAS_ROUNDED_CORNERS 1
+#endif
+#ifdef CLAY3DS_DISABLE_BORDERS
+#define Clay3DSi__HAS_BORDERS 0
+#else
+#define Clay3DSi__HAS_BORDERS 1
+#endif
+#ifdef CLAY3DS_DISABLE_TEXT
+#define Clay3DSi__HAS_TEXT 0
+#else
+#define Clay3DSi__HAS_TEXT 1
+#endif
+#ifdef CLAY3DS_DISABLE_CUSTOM_FONTS
+#define Clay3DSi__HAS_CUSTOM_FONTS 0
+#else
+#define Clay3DSi__HAS_CUSTOM_FONTS 1
+#endif
+#ifdef CLAY3DS_DISABLE_IMAGES
+#define Clay3DSi__HAS_IMAGES 0
+#else
+#define Clay3DSi__HAS_IMAGES 1
+#endif
+#ifdef CLAY3DS_DISABLE_IMAGE_CACHE
+#define Clay3DSi__HAS_IMAGE_CACHE 0
+#else
+#define Clay3DSi__HAS_IMAGE_CACHE Clay3DSi__HAS_IMAGES
+#endif
+#ifdef CLAY3DS_DISABLE_CUSTOM_ELEMENTS
+#define Clay3DSi__HAS_CUSTOM_ELEMENTS 0
+#else
+#define Clay3DSi__HAS_CUSTOM_ELEMENTS 1
+#endif
+#ifdef CLAY3DS_DISABLE_LAYERS
+#define Clay3DSi__HAS_LAYERS 0
+#else
+#define Clay3DSi__HAS_LAYERS 1
+#endif
+#ifdef CLAY3DS_DISABLE_ANTIALIASING
+#define Clay3DSi__HAS_ANTIALIASING 0
+#else
+#define Clay3DSi__HAS_ANTIALIASING 1
+#endif
+
+// Size limits. Each of them can be overridden by defining the matching CLAY3DS_MAX_* macro before including this header.
 // Maximum number of glyphs drawable with each single text draw call.
+#ifdef CLAY3DS_MAX_TEXT_SIZE
+#define Clay3DSi__MAX_TEXT_SIZE CLAY3DS_MAX_TEXT_SIZE
+#else
 #define Clay3DSi__MAX_TEXT_SIZE 4096
+#endif
 // Maximum number of extra fonts that can be loaded at the same time.
+#ifdef CLAY3DS_MAX_FONTS
+#define Clay3DSi__MAX_FONTS CLAY3DS_MAX_FONTS
+#else
 #define Clay3DSi__MAX_FONTS 8
+#endif
+// Maximum number of custom element handlers that can be registered at the same time.
+#ifdef CLAY3DS_MAX_CUSTOM_HANDLERS
+#define Clay3DSi__MAX_CUSTOM_HANDLERS CLAY3DS_MAX_CUSTOM_HANDLERS
+#else
+#define Clay3DSi__MAX_CUSTOM_HANDLERS 16
+#endif
+// Maximum number of blurred shadow textures kept in the cache at the same time.
+#ifdef CLAY3DS_MAX_SHADOWS
+#define Clay3DSi__MAX_SHADOWS CLAY3DS_MAX_SHADOWS
+#else
+#define Clay3DSi__MAX_SHADOWS 16
+#endif
+// Maximum size, in pixels, of the side of a shadow texture.
+#define Clay3DSi__MAX_SHADOW_SIZE 128
+// Maximum number of element subtrees that can be cached as layers at the same time.
+#ifdef CLAY3DS_MAX_LAYERS
+#define Clay3DSi__MAX_LAYERS CLAY3DS_MAX_LAYERS
+#else
+#define Clay3DSi__MAX_LAYERS 8
+#endif
+// Maximum size, in pixels, of the side of a layer texture.
+#define Clay3DSi__MAX_LAYER_SIZE 512
+// Maximum depth of nested clip rectangles (scroll containers).
+#define Clay3DSi__MAX_CLIP_DEPTH 16
+// Maximum number of images that can be referenced through the image cache.
+#ifdef CLAY3DS_MAX_CACHED_IMAGES
+#define Clay3DSi__MAX_CACHED_IMAGES CLAY3DS_MAX_CACHED_IMAGES
+#else
+#define Clay3DSi__MAX_CACHED_IMAGES 64
+#endif
+// Maximum length of the path of a cached image, including the terminator.
+#define Clay3DSi__MAX_IMAGE_PATH 128
+// Maximum number of loaded images uploaded to VRAM in a single frame.
+#define Clay3DSi__MAX_IMAGE_UPLOADS 2
+// Size of the stack of the image loading thread.
+#define Clay3DSi__IMAGE_WORKER_STACK_SIZE (16 * 1024)
+// Maximum number of vertices of the rounded rectangles drawn in batches in a single frame. Twice as many are kept in
+// linear memory, as the GPU could still be reading the ones of the previous frame.
+#ifdef CLAY3DS_MAX_BATCH_VERTICES
+#define Clay3DSi__MAX_BATCH_VERTICES CLAY3DS_MAX_BATCH_VERTICES
+#else
+#define Clay3DSi__MAX_BATCH_VERTICES 8192
+#endif
+// Minimum number of consecutive rounded rectangles drawn as a batch. Each batch hands the GPU over from citro2d and
+// back, which is only worth it for several shapes.
+#define Clay3DSi__MIN_RECT_BATCH 4
+// Number of rounded rectangles whose geometry the batch kernel computes at once, a multiple of 4.
+#define Clay3DSi__RECT_BATCH_LANES 16
+// Maximum number of scroll containers that a frame driver can watch for momentum.
+#define Clay3DSi__MAX_WATCHED_SCROLLS 16
+// Number of segments used to approximate each rounded corner.
+#define Clay3DSi__ARC_SEGMENTS 4
+// Number of triangles generated for each rounded rectangle (5 quads and 4 corner fans).
+#define Clay3DSi__RECT_TRIANGLES (5 * 2 + 4 * Clay3DSi__ARC_SEGMENTS)
+// Number of triangles of the anti-aliasing fringe around each rounded rectangle (4 sides and 4 arcs).
+#define Clay3DSi__FRINGE_TRIANGLES ((4 + 4 * Clay3DSi__ARC_SEGMENTS) * 2)
+// Half of the width of the anti-aliasing fringe, which is centered on the edges of the shapes.
+#define Clay3DSi__FRINGE_HALF_WIDTH 0.5f
+// Number of extra frames a screen keeps being rendered after it was invalidated, so that
+// state changed from Clay callbacks during the layout is also presented.
+#define Clay3DSi__SETTLE_FRAMES 1
 
 #define Clay3DSi__CLAY_COLOR_TO_C2D(cc) C2D_Color32((u8)cc.r, (u8)cc.g, (u8)cc.b, (u8)cc.a)
 #define Clay3DSi__CALC_FONT_SCALE(size) ((float)(size) / 30.f)
-#define Clay3DSi__DEG_TO_RAD(value) ((value) * (M_PI / 180.f))
 #define Clay3DSi__MIN(a, b) ((a) < (b) ? (a) : (b))
+#define Clay3DSi__MAX(a, b) ((a) > (b) ? (a) : (b))
 
 enum
 {
@@ -35,84 +156,288 @@ enum
   Clay3DS_FONT_SYSTEM = 0,
 };
 
-static void Clay3DSi__FillQuad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, u32 color)
+enum
 {
-  C2D_DrawTriangle(x1, y1, color, x2, y2, color, x3, y3, color, 0.f);
-  C2D_DrawTriangle(x1, y1, color, x3, y3, color, x4, y4, color, 0.f);
+  Clay3DS_SCREEN_NONE = 0,
+  Clay3DS_SCREEN_TOP = 1 << 0,
+  Clay3DS_SCREEN_BOTTOM = 1 << 1,
+  Clay3DS_SCREEN_ALL = Clay3DS_SCREEN_TOP | Clay3DS_SCREEN_BOTTOM,
+};
+
+typedef struct
+{
+  // Number of objects that citro2d was initialized with, or zero if the budget is not enforced.
+  u32 maxObjects;
+  // Number of objects used in the current frame, and the most used in a single frame. The peak is
+  // the value to pass to C2D_Init to fit the heaviest frame drawn so far. Rounded rectangles drawn in
+  // batches have their own buffer, and only use one object per batch.
+  u32 usedObjects;
+  u32 peakObjects;
+  // Number of draws rejected, and of rounded rectangles drawn without rounding, because the buffer was full.
+  u32 dropped;
+  u32 degraded;
+} Clay3DS_VertexStats;
+
+static Clay3DS_VertexStats Clay3DSi__vertexStats;
+static u32 Clay3DSi__usedVertices = 0;
+static u32 Clay3DSi__usedIndices = 0;
+// Frame counter value of the frame being counted, used until Clay3DS_ResetVertexBudget is first called.
+static u32 Clay3DSi__budgetFrame = 0;
+static bool Clay3DSi__isBudgetManual = false;
+// Half of the batch vertex arena used by the current frame, and the number of its vertices already drawn.
+static u32 Clay3DSi__batchHalf = 0;
+static u32 Clay3DSi__batchUsed = 0;
+
+// Returns the number of citro2d objects needed for the specified vertex and index counts.
+//
+// citro2d sizes its buffers from the object count (4 vertices and 6 indices per object), and only
+// resets them at the end of each frame, so the geometry drawn by all the render calls adds up.
+static inline u32 Clay3DSi__CountObjects(u32 vertices, u32 indices)
+{
+  return Clay3DSi__MAX((vertices + 3) / 4, (indices + 5) / 6);
 }
 
-static void Clay3DSi__DrawArc(float cx, float cy, float radius, float angs, float ange, float thickness, u32 color)
+static inline void Clay3DSi__ClearVertexUsage(void)
 {
-  u32 segments = 4;
-  float innerRadius = radius - thickness / 2.f;
-  float outerRadius = radius + thickness / 2.f;
+  Clay3DSi__usedVertices = 0;
+  Clay3DSi__usedIndices = 0;
+  Clay3DSi__vertexStats.usedObjects = 0;
+  Clay3DSi__batchHalf ^= 1;
+  Clay3DSi__batchUsed = 0;
+}
 
-  float step = Clay3DSi__DEG_TO_RAD((ange - angs) / segments);
-  float cosStep = cos(step);
-  float sinStep = sin(step);
+// Starts counting a new frame if the vblank counter of the top screen changed, as long as the application does not
+// reset the budget itself.
+static inline void Clay3DSi__SyncBudgetFrame(void)
+{
+  if (!Clay3DSi__isBudgetManual && C3D_FrameCounter(0) != Clay3DSi__budgetFrame)
+  {
+    Clay3DSi__budgetFrame = C3D_FrameCounter(0);
+    Clay3DSi__ClearVertexUsage();
+  }
+}
 
-  float angle = Clay3DSi__DEG_TO_RAD(angs);
-  float cosAngle1 = cos(angle);
-  float sinAngle1 = sin(angle);
+// Accounts for the geometry about to be emitted through citro2d.
+//
+// @return True if the geometry fits in the budget, or false if it must not be drawn.
+static inline bool Clay3DSi__ReserveGeometry(u32 triangles, u32 quads)
+{
+  Clay3DSi__SyncBudgetFrame();
 
-  float xInner1 = cx + innerRadius * cosAngle1;
-  float yInner1 = cy + innerRadius * sinAngle1;
-  float xOuter1 = cx + outerRadius * cosAngle1;
-  float yOuter1 = cy + outerRadius * sinAngle1;
+  u32 vertices = Clay3DSi__usedVertices + triangles * 3 + quads * 4;
+  u32 indices = Clay3DSi__usedIndices + triangles * 3 + quads * 6;
+  u32 objects = Clay3DSi__CountObjects(vertices, indices);
 
-  for (u32 i = 1; i <= segments; ++i)
+  if (Clay3DSi__vertexStats.maxObjects > 0 && objects > Clay3DSi__vertexStats.maxObjects)
   {
-    float cosAngle2 = cosAngle1 * cosStep - sinAngle1 * sinStep;
-    float sinAngle2 = sinAngle1 * cosStep + cosAngle1 * sinStep;
-    float xInner2 = cx + innerRadius * cosAngle2;
-    float yInner2 = cy + innerRadius * sinAngle2;
-    float xOuter2 = cx + outerRadius * cosAngle2;
-    float yOuter2 = cy + outerRadius * sinAngle2;
+    if (Clay3DSi__vertexStats.dropped++ == 0)
+    {
+      fprintf(stderr, "error: citro2d vertex buffer is full (%lu objects), geometry is being dropped\n",
+              (unsigned long)Clay3DSi__vertexStats.maxObjects);
+    }
+    return false;
+  }
+
+  Clay3DSi__usedVertices = vertices;
+  Clay3DSi__usedIndices = indices;
+  Clay3DSi__vertexStats.usedObjects = objects;
+  Clay3DSi__vertexStats.peakObjects = Clay3DSi__MAX(Clay3DSi__vertexStats.peakObjects, objects);
+  return true;
+}
+
+// Enforces the capacity of the citro2d buffers, which must be the same value that was passed to C2D_Init.
+// Draws that would not fit are rejected (or simplified, for rounded rectangles) instead of being silently
+// dropped halfway. Pass zero to only collect the statistics.
+static inline void Clay3DS_SetVertexBudget(u32 maxObjects)
+{
+  Clay3DSi__vertexStats.maxObjects = maxObjects;
+}
+
+// Starts counting the geometry of a new frame.
+//
+// This function should be executed once per frame, after C3D_FrameBegin has been called. Until it is first called,
+// the count restarts whenever C3D_FrameCounter(0) changes, which also happens in the middle of the frames that take
+// longer than a vblank, so the usage of those frames is underestimated. Each new frame also reuses the vertices of the
+// rounded rectangles batched two frames before.
+static inline void Clay3DS_ResetVertexBudget(void)
+{
+  Clay3DSi__isBudgetManual = true;
+  Clay3DSi__ClearVertexUsage();
+}
+
+// Returns the usage statistics of the citro2d buffers.
+static inline Clay3DS_VertexStats Clay3DS_GetVertexStats(void)
+{
+  return Clay3DSi__vertexStats;
+}
+
+// Cosines of the angles that split a quarter circle in Clay3DSi__ARC_SEGMENTS segments.
+// The sine of the i-th angle is the cosine of the (Clay3DSi__ARC_SEGMENTS - i)-th one.
+static const float Clay3DSi__arcTable[Clay3DSi__ARC_SEGMENTS + 1] = {1.f, 0.92387953f, 0.70710678f, 0.38268343f, 0.f};
+
+// Direction of each corner from the center of its arc, in the order top-left, top-right, bottom-right, bottom-left.
+static const float Clay3DSi__cornerSigns[4][2] = {{-1.f, -1.f}, {1.f, -1.f}, {1.f, 1.f}, {-1.f, 1.f}};
+
+static bool Clay3DSi__antialiasing = false;
+
+// Enables or disables edge anti-aliasing. When enabled, rounded corners, borders, and the edges of rectangles that
+// are not aligned to the pixel grid fade to transparent over a one pixel wide fringe, instead of being jagged.
+// The fringe costs a few triangles per shape, which is much cheaper than rendering the whole screen at 2x.
+static inline void Clay3DS_SetAntialiasing(bool enabled)
+{
+  Clay3DSi__antialiasing = enabled;
+}
+
+static inline bool Clay3DSi__IsAntialiased(void)
+{
+  return Clay3DSi__HAS_ANTIALIASING && Clay3DSi__antialiasing;
+}
+
+enum
+{
+  Clay3DSi__CORNER_TOP_LEFT = 0,
+  Clay3DSi__CORNER_TOP_RIGHT = 1,
+  Clay3DSi__CORNER_BOTTOM_RIGHT = 2,
+  Clay3DSi__CORNER_BOTTOM_LEFT = 3,
+};
+
+static inline void Clay3DSi__FillTriangle(float x1, float y1, float x2, float y2, float x3, float y3, u32 color)
+{
+  C2D_DrawTriangle(x1, y1, color, x2, y2, color, x3, y3, color, 0.f);
+}
+
+static inline void Clay3DSi__FillQuad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, u32 color)
+{
+  C2D_DrawTriangle(x1, y1, color, x2, y2, color, x3, y3, color, 0.f);
+  C2D_DrawTriangle(x1, y1, color, x3, y3, color, x4, y4, color, 0.f);
+}
+
+// Fills a quad that fades from the color, along its inner edge (1-2), to transparent, along its outer edge (3-4).
+static inline void Clay3DSi__FillFringeQuad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, u32 color)
+{
+  u32 clear = color & 0x00FFFFFF;
+  C2D_DrawTriangle(x1, y1, color, x2, y2, color, x3, y3, clear, 0.f);
+  C2D_DrawTriangle(x1, y1, color, x3, y3, clear, x4, y4, clear, 0.f);
+}
+
+// Draws a quarter ring. The geometry must have been reserved, including the fringe if it is not zero.
+static inline void Clay3DSi__DrawArc(float cx, float cy, float radius, u32 corner, float thickness, float fringe, u32 color)
+{
+  // With anti-aliasing, the solid ring is shrunk by half a pixel on both sides, and fades over the fringe around it.
+  float h = fringe;
+  float innerRadius = radius - thickness / 2.f;
+  float outerRadius = radius + thickness / 2.f;
+  float fadeRadius = Clay3DSi__MAX(innerRadius - h, 0.f);
+  float sx = Clay3DSi__cornerSigns[corner][0];
+  float sy = Clay3DSi__cornerSigns[corner][1];
 
-    Clay3DSi__FillQuad(xInner1, yInner1, xInner2, yInner2, xOuter2, yOuter2, xOuter1, yOuter1, color);
+  for (u32 i = 0; i < Clay3DSi__ARC_SEGMENTS; ++i)
+  {
+    float cos1 = sx * Clay3DSi__arcTable[i];
+    float sin1 = sy * Clay3DSi__arcTable[Clay3DSi__ARC_SEGMENTS - i];
+    float cos2 = sx * Clay3DSi__arcTable[i + 1];
+    float sin2 = sy * Clay3DSi__arcTable[Clay3DSi__ARC_SEGMENTS - i - 1];
 
-    cosAngle1 = cosAngle2;
-    sinAngle1 = sinAngle2;
-    xInner1 = xInner2;
-    yInner1 = yInner2;
-    xOuter1 = xOuter2;
-    yOuter1 = yOuter2;
+    // clang-format off
+    Clay3DSi__FillQuad(cx + (innerRadius + h) * cos1, cy + (innerRadius + h) * sin1,
+                       cx + (innerRadius + h) * cos2, cy + (innerRadius + h) * sin2,
+                       cx + (outerRadius - h) * cos2, cy + (outerRadius - h) * sin2,
+                       cx + (outerRadius - h) * cos1, cy + (outerRadius - h) * sin1,
+                       color);
+    if (h > 0.f)
+    {
+      Clay3DSi__FillFringeQuad(cx + (outerRadius - h) * cos1, cy + (outerRadius - h) * sin1,
+                               cx + (outerRadius - h) * cos2, cy + (outerRadius - h) * sin2,
+                               cx + (outerRadius + h) * cos2, cy + (outerRadius + h) * sin2,
+                               cx + (outerRadius + h) * cos1, cy + (outerRadius + h) * sin1,
+                               color);
+      Clay3DSi__FillFringeQuad(cx + (innerRadius + h) * cos2, cy + (innerRadius + h) * sin2,
+                               cx + (innerRadius + h) * cos1, cy + (innerRadius + h) * sin1,
+                               cx + fadeRadius * cos1, cy + fadeRadius * sin1,
+                               cx + fadeRadius * cos2, cy + fadeRadius * sin2,
+                               color);
+    }
+    // clang-format on
   }
 }
 
-static void Clay3DSi__FillArc(float cx, float cy, float radius, float angs, float ange, u32 color)
+// Returns the half width of the anti-aliasing fringe of a quarter ring with the specified thickness.
+static inline float Clay3DSi__ArcFringe(float thickness)
+{
+  return Clay3DSi__IsAntialiased() && thickness >= 1.f ? Clay3DSi__FRINGE_HALF_WIDTH : 0.f;
+}
+
+// Draws a rounded rectangle, whose radii must not be bigger than half of any side. The corners are generated from
+// the precomputed arc table. The geometry must have been reserved, including the fringe if it is not zero.
+static inline void Clay3DSi__FillRoundedRect(Clay_BoundingBox box, float tlr, float trr, float brr, float blr, float fringe, u32 color)
 {
-  u32 segments = 4;
+  float x1 = box.x;
+  float y1 = box.y;
+  float x2 = x1 + box.width;
+  float y2 = y1 + box.height;
+  float h = fringe;
+  // With anti-aliasing, the corners are at least as round as the fringe is wide.
+  tlr = Clay3DSi__MAX(tlr, h);
+  trr = Clay3DSi__MAX(trr, h);
+  brr = Clay3DSi__MAX(brr, h);
+  blr = Clay3DSi__MAX(blr, h);
 
-  float step = Clay3DSi__DEG_TO_RAD((ange - angs) / segments);
-  float cosStep = cos(step);
-  float sinStep = sin(step);
+  // Centers of the corner arcs, which are also the vertices of the inner quad.
+  float cx[4] = {x1 + tlr, x2 - trr, x2 - brr, x1 + blr};
+  float cy[4] = {y1 + tlr, y1 + trr, y2 - brr, y2 - blr};
+  float r[4] = {tlr, trr, brr, blr};
 
-  float angle = Clay3DSi__DEG_TO_RAD(angs);
-  float cosAngle1 = cos(angle);
-  float sinAngle1 = sin(angle);
+  // The solid shape is shrunk by half of the fringe, which fades across the original edges.
+  float ix1 = x1 + h;
+  float iy1 = y1 + h;
+  float ix2 = x2 - h;
+  float iy2 = y2 - h;
 
-  float x1 = cx + radius * cosAngle1;
-  float y1 = cy + radius * sinAngle1;
+  Clay3DSi__FillQuad(cx[0], iy1, cx[1], iy1, cx[1], cy[1], cx[0], cy[0], color);     // Top
+  Clay3DSi__FillQuad(cx[1], cy[1], ix2, cy[1], ix2, cy[2], cx[2], cy[2], color);     // Right
+  Clay3DSi__FillQuad(cx[3], cy[3], cx[2], cy[2], cx[2], iy2, cx[3], iy2, color);     // Bottom
+  Clay3DSi__FillQuad(ix1, cy[0], cx[0], cy[0], cx[3], cy[3], ix1, cy[3], color);     // Left
+  Clay3DSi__FillQuad(cx[0], cy[0], cx[1], cy[1], cx[2], cy[2], cx[3], cy[3], color); // Inner
+
+  if (h > 0.f)
+  {
+    Clay3DSi__FillFringeQuad(cx[0], iy1, cx[1], iy1, cx[1], y1 - h, cx[0], y1 - h, color); // Top
+    Clay3DSi__FillFringeQuad(ix2, cy[1], ix2, cy[2], x2 + h, cy[2], x2 + h, cy[1], color); // Right
+    Clay3DSi__FillFringeQuad(cx[2], iy2, cx[3], iy2, cx[3], y2 + h, cx[2], y2 + h, color); // Bottom
+    Clay3DSi__FillFringeQuad(ix1, cy[3], ix1, cy[0], x1 - h, cy[0], x1 - h, cy[3], color); // Left
+  }
 
-  for (u32 i = 1; i <= segments; ++i)
+  for (u32 c = 0; c < 4; ++c)
   {
-    float cosAngle2 = cosAngle1 * cosStep - sinAngle1 * sinStep;
-    float sinAngle2 = sinAngle1 * cosStep + cosAngle1 * sinStep;
-    float x2 = cx + radius * cosAngle2;
-    float y2 = cy + radius * sinAngle2;
+    float sx = Clay3DSi__cornerSigns[c][0];
+    float sy = Clay3DSi__cornerSigns[c][1];
+    float ri = r[c] - h;
+    float ro = r[c] + h;
 
-    C2D_DrawTriangle(cx, cy, color, x1, y1, color, x2, y2, color, 0.f);
+    for (u32 i = 0; i < Clay3DSi__ARC_SEGMENTS; ++i)
+    {
+      float cos1 = sx * Clay3DSi__arcTable[i];
+      float sin1 = sy * Clay3DSi__arcTable[Clay3DSi__ARC_SEGMENTS - i];
+      float cos2 = sx * Clay3DSi__arcTable[i + 1];
+      float sin2 = sy * Clay3DSi__arcTable[Clay3DSi__ARC_SEGMENTS - i - 1];
 
-    cosAngle1 = cosAngle2;
-    sinAngle1 = sinAngle2;
-    x1 = x2;
-    y1 = y2;
+      Clay3DSi__FillTriangle(cx[c], cy[c], cx[c] + ri * cos1, cy[c] + ri * sin1, cx[c] + ri * cos2, cy[c] + ri * sin2, color);
+      if (h > 0.f)
+      {
+        // clang-format off
+        Clay3DSi__FillFringeQuad(cx[c] + ri * cos1, cy[c] + ri * sin1,
+                                 cx[c] + ri * cos2, cy[c] + ri * sin2,
+                                 cx[c] + ro * cos2, cy[c] + ro * sin2,
+                                 cx[c] + ro * cos1, cy[c] + ro * sin1,
+                                 color);
+        // clang-format on
+      }
+    }
   }
 }
 
-static char Clay3DSi__cvTextBuffer[Clay3DSi__MAX_TEXT_SIZE];
-static C2D_TextBuf Clay3DSi__GetStaticTextBuffer(void)
+static char Clay3DSi__cvTextBuffer[Clay3DSi__MAX_TEXT_SIZE + 1];
+static inline C2D_TextBuf Clay3DSi__GetStaticTextBuffer(void)
 {
   static C2D_TextBuf buffer = NULL;
 
@@ -130,9 +455,9 @@ static C2D_TextBuf Clay3DSi__GetStaticTextBuffer(void)
 
 static C2D_Font Clay3DSi__fontList[Clay3DSi__MAX_FONTS];
 static u16 Clay3DSi__numFonts = 0;
-static C2D_Font Clay3DSi__GetFont(s32 id)
+static inline C2D_Font Clay3DSi__GetFont(s32 id)
 {
-  if (id <= Clay3DS_FONT_SYSTEM || id > Clay3DSi__numFonts)
+  if (!Clay3DSi__HAS_CUSTOM_FONTS || id <= Clay3DS_FONT_SYSTEM || id > Clay3DSi__numFonts)
   {
     return NULL;
   }
@@ -144,9 +469,9 @@ static C2D_Font Clay3DSi__GetFont(s32 id)
 //
 // @return The font identifier if successful, or Clay3DS_FONT_INVALID if the maximum
 //         number of registered fonts has been reached.
-static s32 Clay3DS_RegisterFont(C2D_Font font)
+static inline s32 Clay3DS_RegisterFont(C2D_Font font)
 {
-  if (font == NULL || Clay3DSi__numFonts >= Clay3DSi__MAX_FONTS)
+  if (!Clay3DSi__HAS_CUSTOM_FONTS || font == NULL || Clay3DSi__numFonts >= Clay3DSi__MAX_FONTS)
   {
     return Clay3DS_FONT_INVALID;
   }
@@ -156,8 +481,13 @@ static s32 Clay3DS_RegisterFont(C2D_Font font)
 }
 
 // Measures the dimensions of the specified text string based on the provided configuration.
-static Clay_Dimensions Clay3DS_MeasureText(Clay_String* string, Clay_TextElementConfig* config)
+static inline Clay_Dimensions Clay3DS_MeasureText(Clay_String* string, Clay_TextElementConfig* config)
 {
+  if (!Clay3DSi__HAS_TEXT)
+  {
+    return (Clay_Dimensions){0.f, 0.f};
+  }
+
   u32 length = Clay3DSi__MIN(string->length, Clay3DSi__MAX_TEXT_SIZE);
   memcpy(Clay3DSi__cvTextBuffer, string->chars, length);
   Clay3DSi__cvTextBuffer[length] = '\0';
@@ -175,178 +505,2268 @@ static Clay_Dimensions Clay3DS_MeasureText(Clay_String* string, Clay_TextElement
   return dimensions;
 }
 
-// Renders the specified render commands to the given render target.
-//
-// This function should be executed in a loop, after C2D_SceneBegin has been called.
-static void Clay3DS_Render(C3D_RenderTarget* renderTarget, Clay_Dimensions dimensions, Clay_RenderCommandArray renderCommands)
+// Draws a custom element, whose configuration is available in command->config.customElementConfig.
+typedef void (*Clay3DS_CustomDrawFunction)(Clay_RenderCommand* command, void* userData);
+
+typedef struct
+{
+  void* customData;
+  Clay3DS_CustomDrawFunction draw;
+  void* userData;
+} Clay3DSi__CustomHandler;
+
+static Clay3DSi__CustomHandler Clay3DSi__customHandlers[Clay3DSi__MAX_CUSTOM_HANDLERS];
+static u16 Clay3DSi__numCustomHandlers = 0;
+static inline Clay3DSi__CustomHandler* Clay3DSi__FindCustomHandler(void* customData)
 {
-  for (u32 i = 0; i < renderCommands.length; i++)
+  for (u16 i = 0; i < Clay3DSi__numCustomHandlers; ++i)
   {
-    Clay_RenderCommand* renderCommand = Clay_RenderCommandArray_Get(&renderCommands, i);
-    Clay_BoundingBox box = renderCommand->boundingBox;
+    if (Clay3DSi__customHandlers[i].customData == customData)
+    {
+      return &Clay3DSi__customHandlers[i];
+    }
+  }
 
-    switch (renderCommand->commandType)
+  return NULL;
+}
+
+// Registers the function that draws the custom elements whose customData is the specified pointer.
+// Registering the same customData again replaces its handler.
+//
+// @return True if successful, or false if the maximum number of registered handlers has been reached.
+static inline bool Clay3DS_RegisterCustomHandler(void* customData, Clay3DS_CustomDrawFunction draw, void* userData)
+{
+  Clay3DSi__CustomHandler* handler = Clay3DSi__FindCustomHandler(customData);
+  if (handler == NULL)
+  {
+    if (draw == NULL || Clay3DSi__numCustomHandlers >= Clay3DSi__MAX_CUSTOM_HANDLERS)
     {
-    case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
-      Clay_RectangleElementConfig* config = renderCommand->config.rectangleElementConfig;
-      u32 color = Clay3DSi__CLAY_COLOR_TO_C2D(config->color);
-      float tlr = config->cornerRadius.topLeft;
-      float trr = config->cornerRadius.topRight;
-      float brr = config->cornerRadius.bottomRight;
-      float blr = config->cornerRadius.bottomLeft;
+      return false;
+    }
 
-      if (tlr <= 0.f && trr <= 0.f && brr <= 0.f && blr <= 0.f)
-      {
-        // If no rounding is used, fall back to the faster, simpler, rectangle drawing.
-        C2D_DrawRectSolid(box.x, box.y, 0.f, box.width, box.height, color);
-      }
-      else
-      {
-        // Make sure that the rounding is not bigger than half of any side.
-        float max = Clay3DSi__MIN(box.width, box.height) / 2.f;
-        tlr = Clay3DSi__MIN(tlr, max);
-        trr = Clay3DSi__MIN(trr, max);
-        brr = Clay3DSi__MIN(brr, max);
-        blr = Clay3DSi__MIN(blr, max);
+    handler = &Clay3DSi__customHandlers[Clay3DSi__numCustomHandlers++];
+  }
 
-        // clang-format off
-        Clay3DSi__FillQuad(box.x + tlr, box.y,
-                           box.x + box.width - trr, box.y,
-                           box.x + box.width - trr, box.y + trr,
-                           box.x + tlr, box.y + tlr,
-                           color); // Top
-        Clay3DSi__FillQuad(box.x + box.width - trr, box.y + trr,
-                           box.x + box.width, box.y + trr,
-                           box.x + box.width, box.y + box.height - brr,
-                           box.x + box.width - brr, box.y + box.height - brr,
-                           color); // Right
-        Clay3DSi__FillQuad(box.x + blr, box.y + box.height - blr,
-                           box.x + box.width - brr, box.y + box.height - brr,
-                           box.x + box.width - brr, box.y + box.height,
-                           box.x + blr, box.y + box.height,
-                           color); // Bottom
-        Clay3DSi__FillQuad(box.x, box.y + tlr,
-                           box.x + tlr, box.y + tlr,
-                           box.x + blr, box.y + box.height - blr,
-                           box.x, box.y + box.height - blr,
-                           color); // Left
-        Clay3DSi__FillQuad(box.x + tlr, box.y + tlr,
-                           box.x + box.width - trr, box.y + trr,
-                           box.x + box.width - brr, box.y + box.height - brr,
-                           box.x + blr, box.y + box.height - blr,
-                           color); // Inner
-        // clang-format on
+  *handler = (Clay3DSi__CustomHandler){customData, draw, userData};
+  return true;
+}
 
-        Clay3DSi__FillArc(box.x + tlr, box.y + tlr, tlr, 180.f, 270.f, color);                       // Top Left
-        Clay3DSi__FillArc(box.x + box.width - trr, box.y + trr, trr, 270.f, 360.f, color);           // Top Right
-        Clay3DSi__FillArc(box.x + box.width - brr, box.y + box.height - brr, brr, 0.f, 90.f, color); // Bottom Right
-        Clay3DSi__FillArc(box.x + blr, box.y + box.height - blr, blr, 90.f, 180.f, color);           // Bottom Left
-      }
+// Removes the handler registered for the specified customData, if any.
+static inline void Clay3DS_UnregisterCustomHandler(void* customData)
+{
+  Clay3DSi__CustomHandler* handler = Clay3DSi__FindCustomHandler(customData);
+  if (handler != NULL)
+  {
+    *handler = Clay3DSi__customHandlers[--Clay3DSi__numCustomHandlers];
+  }
+}
 
-      break;
-    }
-    case CLAY_RENDER_COMMAND_TYPE_BORDER: {
-      Clay_BorderElementConfig* config = renderCommand->config.borderElementConfig;
-      u32 tc = Clay3DSi__CLAY_COLOR_TO_C2D(config->top.color);
-      u32 lc = Clay3DSi__CLAY_COLOR_TO_C2D(config->left.color);
-      u32 rc = Clay3DSi__CLAY_COLOR_TO_C2D(config->right.color);
-      u32 bc = Clay3DSi__CLAY_COLOR_TO_C2D(config->bottom.color);
-      float lw = config->left.width;
-      float tw = config->top.width;
-      float rw = config->right.width;
-      float bw = config->bottom.width;
-      // Make sure that the rounding is not bigger than half of any side.
-      float max = Clay3DSi__MIN(box.width, box.height) / 2.f;
-      float tlr = Clay3DSi__MIN(config->cornerRadius.topLeft, max);
-      float trr = Clay3DSi__MIN(config->cornerRadius.topRight, max);
-      float brr = Clay3DSi__MIN(config->cornerRadius.bottomRight, max);
-      float blr = Clay3DSi__MIN(config->cornerRadius.bottomLeft, max);
+// Vertex in the layout of the citro2d vertex buffer, so that meshes are drawn with its shader and attributes.
+typedef struct
+{
+  float position[3];
+  float texcoord[2];
+  float blend[2];
+  u32 color;
+} Clay3DSi__MeshVertex;
 
-      if (config->top.width > 0.f)
-      {
-        C2D_DrawRectSolid(box.x + tlr, box.y, 0.f, box.width - tlr - trr, tw, tc);
-      }
-      if (config->left.width > 0.f)
-      {
-        C2D_DrawRectSolid(box.x, box.y + tlr, 0.f, lw, box.height - tlr - blr, lc);
-      }
-      if (config->right.width > 0.f)
-      {
-        C2D_DrawRectSolid(box.x + box.width - rw, box.y + trr, 0.f, rw, box.height - trr - brr, rc);
-      }
-      if (config->bottom.width > 0.f)
-      {
-        C2D_DrawRectSolid(box.x + brr, box.y + box.height - bw, 0.f, box.width - blr - brr, bw, bc);
-      }
-      if (tlr > 0.f)
-      {
-        Clay3DSi__DrawArc(box.x + tlr, box.y + tlr, tlr - tw / 2.f, 180.f, 270.f, tw, tc);
-      }
-      if (trr > 0.f)
-      {
-        Clay3DSi__DrawArc(box.x + box.width - trr, box.y + trr, trr - tw / 2.f, 270.f, 360.f, tw, tc);
-      }
-      if (blr > 0.f)
-      {
-        Clay3DSi__DrawArc(box.x + blr, box.y + box.height - blr, blr - bw / 2.f, 90.f, 180.f, bw, bc);
-      }
-      if (brr > 0.f)
-      {
-        Clay3DSi__DrawArc(box.x + box.width - brr, box.y + box.height - brr, brr - bw / 2.f, 0.f, 90.f, bw, bc);
-      }
+// Static triangle mesh, defined in its own coordinate space of size width x height. The vertices live in linear
+// memory, where the GPU reads them directly, so a mesh costs the same few commands per frame whatever its size.
+typedef struct
+{
+  Clay3DSi__MeshVertex* vertices;
+  u32 numVertices;
+  u32 capacity;
+  float width;
+  float height;
+  // Whether the vertices were changed since they were last flushed from the CPU cache.
+  bool dirty;
+} Clay3DS_Mesh;
 
-      break;
-    }
-    case CLAY_RENDER_COMMAND_TYPE_TEXT: {
-      Clay_TextElementConfig* config = renderCommand->config.textElementConfig;
-      u32 color = Clay3DSi__CLAY_COLOR_TO_C2D(config->textColor);
+// Creates an empty mesh, which can hold up to maxTriangles triangles.
+//
+// @return The created mesh, or NULL if the allocation failed.
+static inline Clay3DS_Mesh* Clay3DS_MeshCreate(float width, float height, u32 maxTriangles)
+{
+  Clay3DS_Mesh* mesh = (Clay3DS_Mesh*)malloc(sizeof(Clay3DS_Mesh));
+  if (mesh == NULL)
+  {
+    return NULL;
+  }
+
+  mesh->vertices = (Clay3DSi__MeshVertex*)linearAlloc(sizeof(Clay3DSi__MeshVertex) * maxTriangles * 3);
+  if (mesh->vertices == NULL)
+  {
+    free(mesh);
+    return NULL;
+  }
 
-      Clay_String string = renderCommand->text;
-      u32 length = Clay3DSi__MIN(string.length, Clay3DSi__MAX_TEXT_SIZE);
-      memcpy(Clay3DSi__cvTextBuffer, string.chars, length);
-      Clay3DSi__cvTextBuffer[length] = '\0';
+  mesh->numVertices = 0;
+  mesh->capacity = maxTriangles * 3;
+  mesh->width = width;
+  mesh->height = height;
+  mesh->dirty = false;
+  return mesh;
+}
 
-      C2D_Font font = Clay3DSi__GetFont(config->fontId);
-      float scale = Clay3DSi__CALC_FONT_SCALE(config->fontSize);
+// Releases the mesh, which must not have been drawn in the current frame, or in the previous one.
+static inline void Clay3DS_MeshDelete(Clay3DS_Mesh* mesh)
+{
+  if (mesh != NULL)
+  {
+    linearFree(mesh->vertices);
+    free(mesh);
+  }
+}
 
-      C2D_Text text;
-      C2D_TextBuf buffer = Clay3DSi__GetStaticTextBuffer();
-      C2D_TextFontParse(&text, font, buffer, Clay3DSi__cvTextBuffer);
-      C2D_TextOptimize(&text);
-      C2D_DrawText(&text, C2D_WithColor, box.x, box.y, 0.f, scale, scale, color);
-      break;
-    }
-    case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
-      Clay_ImageElementConfig* config = renderCommand->config.imageElementConfig;
-      C2D_DrawParams params = {{box.x, box.y, box.width, box.height}, {0.f, 0.f}, 0.f, 0.f};
+// Removes all the triangles from the mesh, so that it can be built again.
+//
+// The GPU reads the vertices while the frame is drawn, so a mesh drawn in the previous frame should only be
+// changed after C3D_FrameBegin(C3D_FRAME_SYNCDRAW) has been called.
+static inline void Clay3DS_MeshClear(Clay3DS_Mesh* mesh)
+{
+  mesh->numVertices = 0;
+}
+
+// Appends a triangle to the mesh. The coordinates are in the mesh space.
+//
+// @return True if successful, or false if the mesh is full.
+static inline bool Clay3DS_MeshAddTriangle(Clay3DS_Mesh* mesh, float x1, float y1, u32 c1, float x2, float y2, u32 c2, float x3, float y3,
+                                           u32 c3)
+{
+  if (mesh->numVertices + 3 > mesh->capacity)
+  {
+    return false;
+  }
+
+  // Texture and blend coordinates are the ones citro2d gives to the vertices of solid color triangles.
+  Clay3DSi__MeshVertex* v = &mesh->vertices[mesh->numVertices];
+  v[0] = (Clay3DSi__MeshVertex){{x1, y1, 0.f}, {-1.f, 1.f}, {0.f, 1.f}, c1};
+  v[1] = (Clay3DSi__MeshVertex){{x2, y2, 0.f}, {-1.f, 1.f}, {0.f, 1.f}, c2};
+  v[2] = (Clay3DSi__MeshVertex){{x3, y3, 0.f}, {-1.f, 1.f}, {0.f, 1.f}, c3};
+  mesh->numVertices += 3;
+  mesh->dirty = true;
+  return true;
+}
+
+// Source factors of the alpha blending currently set, for the color and the alpha channel.
+static GPU_BLENDFACTOR Clay3DSi__blendFactors[2] = {GPU_SRC_ALPHA, GPU_SRC_ALPHA};
+
+// Sets the alpha blending with the specified source factors for the color and the alpha channel. The destination is
+// always scaled by one minus the source alpha, and citro2d itself uses GPU_SRC_ALPHA for both channels.
+static inline void Clay3DSi__SetAlphaBlend(GPU_BLENDFACTOR colorFactor, GPU_BLENDFACTOR alphaFactor)
+{
+  C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, colorFactor, GPU_ONE_MINUS_SRC_ALPHA, alphaFactor, GPU_ONE_MINUS_SRC_ALPHA);
+  Clay3DSi__blendFactors[0] = colorFactor;
+  Clay3DSi__blendFactors[1] = alphaFactor;
+}
+
+// Draws solid color triangles from vertices in linear memory, already flushed from the CPU cache, with the current
+// citro2d transform. The geometry of one triangle must have been reserved.
+static inline void Clay3DSi__DrawVertices(const Clay3DSi__MeshVertex* vertices, u32 numVertices)
+{
+  // citro2d only uploads the transform, and sets up the combiners for solid colors, when something is drawn. An
+  // empty triangle makes it configure the GPU for the vertices, whose buffer then replaces the citro2d one.
+  C2D_DrawTriangle(0.f, 0.f, 0, 0.f, 0.f, 0, 0.f, 0.f, 0, 0.f);
+  C2D_Flush();
+
+  C3D_BufInfo* bufInfo = C3D_GetBufInfo();
+  BufInfo_Init(bufInfo);
+  BufInfo_Add(bufInfo, vertices, sizeof(Clay3DSi__MeshVertex), 4, 0x3210);
+  C3D_DrawArrays(GPU_TRIANGLES, 0, numVertices);
+
+  // Hand the GPU back to citro2d, which binds its own buffer again and uploads its state before the next draw. This
+  // also resets the blending, which is different while drawing to a layer.
+  C2D_Prepare();
+  if (Clay3DSi__blendFactors[0] != GPU_SRC_ALPHA || Clay3DSi__blendFactors[1] != GPU_SRC_ALPHA)
+  {
+    Clay3DSi__SetAlphaBlend(Clay3DSi__blendFactors[0], Clay3DSi__blendFactors[1]);
+  }
+}
+
+// Draws the mesh stretched to the specified box. The triangles are read by the GPU from the mesh itself, and only
+// the transform is uploaded on each frame.
+static inline void Clay3DS_DrawMesh(Clay3DS_Mesh* mesh, Clay_BoundingBox box)
+{
+  if (mesh == NULL || mesh->numVertices == 0 || mesh->width <= 0.f || mesh->height <= 0.f)
+  {
+    return;
+  }
+
+  // Only the invisible triangle drawn to set up the GPU goes through the citro2d buffers.
+  if (!Clay3DSi__ReserveGeometry(1, 0))
+  {
+    return;
+  }
+
+  if (mesh->dirty)
+  {
+    GSPGPU_FlushDataCache(mesh->vertices, sizeof(Clay3DSi__MeshVertex) * mesh->numVertices);
+    mesh->dirty = false;
+  }
+
+  C3D_Mtx view;
+  C2D_ViewSave(&view);
+  C2D_ViewTranslate(box.x, box.y);
+  C2D_ViewScale(box.width / mesh->width, box.height / mesh->height);
+  Clay3DSi__DrawVertices(mesh->vertices, mesh->numVertices);
+  C2D_ViewRestore(&view);
+}
+
+// Custom draw function that renders the Clay3DS_Mesh passed as userData in the element's bounding box.
+static inline void Clay3DS_MeshHandler(Clay_RenderCommand* command, void* userData)
+{
+  Clay3DS_DrawMesh((Clay3DS_Mesh*)userData, command->boundingBox);
+}
+
+// Coordinates, on each axis, that the geometry of a rounded rectangle is built from. The quads and the fringe of
+// Clay3DSi__FillRoundedRect only join these, so a vertex is fully described by one x and one y index.
+enum
+{
+  // Centers of the corner arcs, in the order top-left, top-right, bottom-right, bottom-left.
+  Clay3DSi__COORD_CENTER = 0,
+  // Sides of the solid shape, and of its fringe, first the left (or top) one and then the right (or bottom) one.
+  Clay3DSi__COORD_INNER = 4,
+  Clay3DSi__COORD_OUTER = 6,
+  // Points of the corner arcs, Clay3DSi__ARC_SEGMENTS + 1 per corner, on the solid shape and on its fringe.
+  Clay3DSi__COORD_INNER_ARC = 8,
+  Clay3DSi__COORD_OUTER_ARC = Clay3DSi__COORD_INNER_ARC + 4 * (Clay3DSi__ARC_SEGMENTS + 1),
+  Clay3DSi__RECT_COORDS = Clay3DSi__COORD_OUTER_ARC + 4 * (Clay3DSi__ARC_SEGMENTS + 1),
+};
+
+typedef struct
+{
+  u8 x;
+  u8 y;
+  // Whether the vertex is on the outer edge of the fringe, where the color fades to transparent.
+  u8 isClear;
+} Clay3DSi__RectVertex;
+
+// Vertices of the triangles of a rounded rectangle without and with its fringe, in the same order as the ones drawn by
+// Clay3DSi__FillRoundedRect.
+static Clay3DSi__RectVertex Clay3DSi__rectTopology[2][(Clay3DSi__RECT_TRIANGLES + Clay3DSi__FRINGE_TRIANGLES) * 3];
+static bool Clay3DSi__isRectTopologyBuilt = false;
+
+// Structure of arrays with the rounded rectangles of a batch, and the coordinates computed by the kernel for them.
+typedef struct
+{
+  float x[Clay3DSi__RECT_BATCH_LANES];
+  float y[Clay3DSi__RECT_BATCH_LANES];
+  float width[Clay3DSi__RECT_BATCH_LANES];
+  float height[Clay3DSi__RECT_BATCH_LANES];
+  // Radii of each corner, which must not be bigger than half of any side.
+  float radius[4][Clay3DSi__RECT_BATCH_LANES];
+  u32 color[Clay3DSi__RECT_BATCH_LANES];
+  u32 count;
+  // Half width of the anti-aliasing fringe of all the rectangles, or zero.
+  float fringe;
+
+  float coordX[Clay3DSi__RECT_COORDS][Clay3DSi__RECT_BATCH_LANES];
+  float coordY[Clay3DSi__RECT_COORDS][Clay3DSi__RECT_BATCH_LANES];
+} Clay3DSi__RectBatch;
+
+static Clay3DSi__RectBatch Clay3DSi__rectBatch;
+// Linear memory holding the vertices of the batches of two frames, one after the other.
+static Clay3DSi__MeshVertex* Clay3DSi__batchArena = NULL;
+static bool Clay3DSi__batchArenaFailed = false;
+
+// Appends the two triangles of the quad 1-2-3-4 to the topology. When it is a fringe, 3 and 4 are on the outer edge.
+static inline Clay3DSi__RectVertex* Clay3DSi__PutQuad(Clay3DSi__RectVertex* v, const u8 (*points)[2], bool isFringe)
+{
+  const u8 order[6] = {0, 1, 2, 0, 2, 3};
+  for (u32 i = 0; i < 6; ++i)
+  {
+    *v++ = (Clay3DSi__RectVertex){points[order[i]][0], points[order[i]][1], isFringe && order[i] >= 2};
+  }
+  return v;
+}
+
+static inline void Clay3DSi__BuildRectTopology(Clay3DSi__RectVertex* v, bool hasFringe)
+{
+  const u8 c = Clay3DSi__COORD_CENTER;
+  const u8 i = Clay3DSi__COORD_INNER;
+  const u8 o = Clay3DSi__COORD_OUTER;
 
-      if (config->imageData != NULL)
+  // clang-format off
+  const u8 quads[5][4][2] = {
+    {{c + 0, i + 0}, {c + 1, i + 0}, {c + 1, c + 1}, {c + 0, c + 0}}, // Top
+    {{c + 1, c + 1}, {i + 1, c + 1}, {i + 1, c + 2}, {c + 2, c + 2}}, // Right
+    {{c + 3, c + 3}, {c + 2, c + 2}, {c + 2, i + 1}, {c + 3, i + 1}}, // Bottom
+    {{i + 0, c + 0}, {c + 0, c + 0}, {c + 3, c + 3}, {i + 0, c + 3}}, // Left
+    {{c + 0, c + 0}, {c + 1, c + 1}, {c + 2, c + 2}, {c + 3, c + 3}}, // Inner
+  };
+  const u8 fringes[4][4][2] = {
+    {{c + 0, i + 0}, {c + 1, i + 0}, {c + 1, o + 0}, {c + 0, o + 0}}, // Top
+    {{i + 1, c + 1}, {i + 1, c + 2}, {o + 1, c + 2}, {o + 1, c + 1}}, // Right
+    {{c + 2, i + 1}, {c + 3, i + 1}, {c + 3, o + 1}, {c + 2, o + 1}}, // Bottom
+    {{i + 0, c + 3}, {i + 0, c + 0}, {o + 0, c + 0}, {o + 0, c + 3}}, // Left
+  };
+  // clang-format on
+
+  for (u32 q = 0; q < 5; ++q)
+  {
+    v = Clay3DSi__PutQuad(v, quads[q], false);
+  }
+  for (u32 q = 0; hasFringe && q < 4; ++q)
+  {
+    v = Clay3DSi__PutQuad(v, fringes[q], true);
+  }
+
+  for (u8 corner = 0; corner < 4; ++corner)
+  {
+    for (u8 s = 0; s < Clay3DSi__ARC_SEGMENTS; ++s)
+    {
+      u8 inner = Clay3DSi__COORD_INNER_ARC + corner * (Clay3DSi__ARC_SEGMENTS + 1) + s;
+      u8 outer = Clay3DSi__COORD_OUTER_ARC + corner * (Clay3DSi__ARC_SEGMENTS + 1) + s;
+      *v++ = (Clay3DSi__RectVertex){c + corner, c + corner, false};
+      *v++ = (Clay3DSi__RectVertex){inner, inner, false};
+      *v++ = (Clay3DSi__RectVertex){inner + 1, inner + 1, false};
+      if (hasFringe)
       {
-        C2D_DrawImage(*(C2D_Image*)config->imageData, &params, NULL);
+        const u8 fringe[4][2] = {{inner, inner}, {inner + 1, inner + 1}, {outer + 1, outer + 1}, {outer, outer}};
+        v = Clay3DSi__PutQuad(v, fringe, true);
       }
-      break;
     }
-    case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
-      C2D_SceneBegin(renderTarget);
-      // clang-format off
-      C3D_SetScissor(GPU_SCISSOR_NORMAL,
-                     dimensions.height - box.height - box.y,
-                     dimensions.width - box.width - box.x,
-                     box.height + box.y,
-                     dimensions.width - box.x);
-      // clang-format on
-      break;
+  }
+}
+
+// Computes the coordinates of the rounded rectangles in the batch, one rectangle at a time. This is the reference for
+// the vectorized kernels, and it performs the same operations as Clay3DSi__FillRoundedRect.
+static inline void Clay3DSi__ComputeRectCoordsScalar(Clay3DSi__RectBatch* batch)
+{
+  float h = batch->fringe;
+  for (u32 n = 0; n < batch->count; ++n)
+  {
+    float x1 = batch->x[n];
+    float y1 = batch->y[n];
+    float x2 = x1 + batch->width[n];
+    float y2 = y1 + batch->height[n];
+    float r[4];
+    for (u32 c = 0; c < 4; ++c)
+    {
+      r[c] = Clay3DSi__MAX(batch->radius[c][n], h);
     }
-    case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END: {
-      C3D_SetScissor(GPU_SCISSOR_DISABLE, 0, 0, 0, 0);
-      break;
+
+    float cx[4] = {x1 + r[0], x2 - r[1], x2 - r[2], x1 + r[3]};
+    float cy[4] = {y1 + r[0], y1 + r[1], y2 - r[2], y2 - r[3]};
+    batch->coordX[Clay3DSi__COORD_INNER][n] = x1 + h;
+    batch->coordX[Clay3DSi__COORD_INNER + 1][n] = x2 - h;
+    batch->coordX[Clay3DSi__COORD_OUTER][n] = x1 - h;
+    batch->coordX[Clay3DSi__COORD_OUTER + 1][n] = x2 + h;
+    batch->coordY[Clay3DSi__COORD_INNER][n] = y1 + h;
+    batch->coordY[Clay3DSi__COORD_INNER + 1][n] = y2 - h;
+    batch->coordY[Clay3DSi__COORD_OUTER][n] = y1 - h;
+    batch->coordY[Clay3DSi__COORD_OUTER + 1][n] = y2 + h;
+
+    for (u32 c = 0; c < 4; ++c)
+    {
+      batch->coordX[Clay3DSi__COORD_CENTER + c][n] = cx[c];
+      batch->coordY[Clay3DSi__COORD_CENTER + c][n] = cy[c];
+
+      float ri = r[c] - h;
+      float ro = r[c] + h;
+      for (u32 k = 0; k <= Clay3DSi__ARC_SEGMENTS; ++k)
+      {
+        float cosine = Clay3DSi__cornerSigns[c][0] * Clay3DSi__arcTable[k];
+        float sine = Clay3DSi__cornerSigns[c][1] * Clay3DSi__arcTable[Clay3DSi__ARC_SEGMENTS - k];
+        u32 point = c * (Clay3DSi__ARC_SEGMENTS + 1) + k;
+        batch->coordX[Clay3DSi__COORD_INNER_ARC + point][n] = cx[c] + ri * cosine;
+        batch->coordY[Clay3DSi__COORD_INNER_ARC + point][n] = cy[c] + ri * sine;
+        batch->coordX[Clay3DSi__COORD_OUTER_ARC + point][n] = cx[c] + ro * cosine;
+        batch->coordY[Clay3DSi__COORD_OUTER_ARC + point][n] = cy[c] + ro * sine;
+      }
     }
-    default: {
-      fprintf(stderr, "error: unhandled render command: %d\n", renderCommand->commandType);
-      exit(1);
+  }
+}
+
+#ifdef __SSE__
+// Computes the coordinates of the rounded rectangles in the batch, four at a time. The results are the same as the
+// ones of Clay3DSi__ComputeRectCoordsScalar, as every operation is rounded the same way.
+static inline void Clay3DSi__ComputeRectCoordsSSE(Clay3DSi__RectBatch* batch)
+{
+  __m128 h = _mm_set1_ps(batch->fringe);
+  for (u32 n = 0; n < batch->count; n += 4)
+  {
+    __m128 x1 = _mm_loadu_ps(&batch->x[n]);
+    __m128 y1 = _mm_loadu_ps(&batch->y[n]);
+    __m128 x2 = _mm_add_ps(x1, _mm_loadu_ps(&batch->width[n]));
+    __m128 y2 = _mm_add_ps(y1, _mm_loadu_ps(&batch->height[n]));
+    __m128 r[4];
+    for (u32 c = 0; c < 4; ++c)
+    {
+      r[c] = _mm_max_ps(_mm_loadu_ps(&batch->radius[c][n]), h);
     }
+
+    __m128 cx[4] = {_mm_add_ps(x1, r[0]), _mm_sub_ps(x2, r[1]), _mm_sub_ps(x2, r[2]), _mm_add_ps(x1, r[3])};
+    __m128 cy[4] = {_mm_add_ps(y1, r[0]), _mm_add_ps(y1, r[1]), _mm_sub_ps(y2, r[2]), _mm_sub_ps(y2, r[3])};
+    _mm_storeu_ps(&batch->coordX[Clay3DSi__COORD_INNER][n], _mm_add_ps(x1, h));
+    _mm_storeu_ps(&batch->coordX[Clay3DSi__COORD_INNER + 1][n], _mm_sub_ps(x2, h));
+    _mm_storeu_ps(&batch->coordX[Clay3DSi__COORD_OUTER][n], _mm_sub_ps(x1, h));
+    _mm_storeu_ps(&batch->coordX[Clay3DSi__COORD_OUTER + 1][n], _mm_add_ps(x2, h));
+    _mm_storeu_ps(&batch->coordY[Clay3DSi__COORD_INNER][n], _mm_add_ps(y1, h));
+    _mm_storeu_ps(&batch->coordY[Clay3DSi__COORD_INNER + 1][n], _mm_sub_ps(y2, h));
+    _mm_storeu_ps(&batch->coordY[Clay3DSi__COORD_OUTER][n], _mm_sub_ps(y1, h));
+    _mm_storeu_ps(&batch->coordY[Clay3DSi__COORD_OUTER + 1][n], _mm_add_ps(y2, h));
+
+    for (u32 c = 0; c < 4; ++c)
+    {
+      _mm_storeu_ps(&batch->coordX[Clay3DSi__COORD_CENTER + c][n], cx[c]);
+      _mm_storeu_ps(&batch->coordY[Clay3DSi__COORD_CENTER + c][n], cy[c]);
+
+      __m128 ri = _mm_sub_ps(r[c], h);
+      __m128 ro = _mm_add_ps(r[c], h);
+      for (u32 k = 0; k <= Clay3DSi__ARC_SEGMENTS; ++k)
+      {
+        __m128 cosine = _mm_set1_ps(Clay3DSi__cornerSigns[c][0] * Clay3DSi__arcTable[k]);
+        __m128 sine = _mm_set1_ps(Clay3DSi__cornerSigns[c][1] * Clay3DSi__arcTable[Clay3DSi__ARC_SEGMENTS - k]);
+        u32 point = c * (Clay3DSi__ARC_SEGMENTS + 1) + k;
+        _mm_storeu_ps(&batch->coordX[Clay3DSi__COORD_INNER_ARC + point][n], _mm_add_ps(cx[c], _mm_mul_ps(ri, cosine)));
+        _mm_storeu_ps(&batch->coordY[Clay3DSi__COORD_INNER_ARC + point][n], _mm_add_ps(cy[c], _mm_mul_ps(ri, sine)));
+        _mm_storeu_ps(&batch->coordX[Clay3DSi__COORD_OUTER_ARC + point][n], _mm_add_ps(cx[c], _mm_mul_ps(ro, cosine)));
+        _mm_storeu_ps(&batch->coordY[Clay3DSi__COORD_OUTER_ARC + point][n], _mm_add_ps(cy[c], _mm_mul_ps(ro, sine)));
+      }
     }
   }
 }
+#endif
+
+// Returns the number of vertices of each rounded rectangle in a batch with the specified fringe.
+static inline u32 Clay3DSi__RectBatchVertices(float fringe)
+{
+  return (Clay3DSi__RECT_TRIANGLES + (fringe > 0.f ? Clay3DSi__FRINGE_TRIANGLES : 0)) * 3;
+}
+
+// Writes the vertices of the rounded rectangles in the batch to the specified buffer, which must have room for all of
+// them, in the layout of the citro2d vertex buffer.
+//
+// @return The end of the written vertices.
+static inline Clay3DSi__MeshVertex* Clay3DSi__BuildRectBatch(Clay3DSi__RectBatch* batch, Clay3DSi__MeshVertex* v)
+{
+  if (!Clay3DSi__isRectTopologyBuilt)
+  {
+    Clay3DSi__BuildRectTopology(Clay3DSi__rectTopology[0], false);
+    Clay3DSi__BuildRectTopology(Clay3DSi__rectTopology[1], true);
+    Clay3DSi__isRectTopologyBuilt = true;
+  }
+
+#ifdef __SSE__
+  Clay3DSi__ComputeRectCoordsSSE(batch);
+#else
+  Clay3DSi__ComputeRectCoordsScalar(batch);
+#endif
+
+  const Clay3DSi__RectVertex* topology = Clay3DSi__rectTopology[batch->fringe > 0.f];
+  u32 numVertices = Clay3DSi__RectBatchVertices(batch->fringe);
+  for (u32 n = 0; n < batch->count; ++n)
+  {
+    // Texture and blend coordinates are the ones citro2d gives to the vertices of solid color triangles.
+    u32 colors[2] = {batch->color[n], batch->color[n] & 0x00FFFFFF};
+#ifdef __SSE__
+    // The second half of each vertex only depends on whether its color fades, so it is written with a single store.
+    __m128 tails[2];
+    for (u32 i = 0; i < 2; ++i)
+    {
+      Clay3DSi__MeshVertex tail = {{0.f, 0.f, 0.f}, {-1.f, 1.f}, {0.f, 1.f}, colors[i]};
+      tails[i] = _mm_loadu_ps(&tail.texcoord[1]);
+    }
+#endif
+
+    for (u32 i = 0; i < numVertices; ++i, ++v)
+    {
+      Clay3DSi__RectVertex vertex = topology[i];
+      float x = batch->coordX[vertex.x][n];
+      float y = batch->coordY[vertex.y][n];
+#ifdef __SSE__
+      _mm_storeu_ps(v->position, _mm_setr_ps(x, y, 0.f, -1.f));
+      _mm_storeu_ps(&v->texcoord[1], tails[vertex.isClear]);
+#else
+      *v = (Clay3DSi__MeshVertex){{x, y, 0.f}, {-1.f, 1.f}, {0.f, 1.f}, colors[vertex.isClear]};
+#endif
+    }
+  }
+
+  return v;
+}
+
+// Blurred rounded rectangle drawn behind an element. To cast it, use a pointer to this structure as the
+// customData of a custom element, register Clay3DS_ShadowHandler for it, and call Clay3DS_ShadowCacheUpdate every frame.
+typedef struct
+{
+  Clay_Color color;
+  float cornerRadius;
+  float blur;
+  Clay_Vector2 offset;
+} Clay3DS_Shadow;
+
+typedef struct
+{
+  C3D_Tex tex;
+  u16 radius;
+  u16 blur;
+  // Size, in pixels, of the corner slices of the texture.
+  u16 corner;
+  u32 lastUsed;
+  bool valid;
+} Clay3DSi__ShadowEntry;
+
+static Clay3DSi__ShadowEntry Clay3DSi__shadowCache[Clay3DSi__MAX_SHADOWS];
+static u32 Clay3DSi__shadowFrame = 0;
+static u32 Clay3DSi__shadowMisses = 0;
+
+// Starts a new frame for the shadow cache. The textures drawn in the current and in the previous frame could still
+// be read by the GPU, so only older ones are replaced when the cache is full.
+//
+// This function should be executed once per frame, before C3D_FrameBegin has been called. Without it no texture is
+// ever replaced, and the shadows that do not fit in the cache are not drawn (which is reported on stderr).
+static inline void Clay3DS_ShadowCacheUpdate(void)
+{
+  Clay3DSi__shadowFrame++;
+}
+
+// Returns the offset of the texel at the specified coordinates in a tiled (morton order) texture.
+static inline u32 Clay3DSi__TexelOffset(u32 x, u32 y, u32 width)
+{
+  u32 tile = ((y >> 3) * (width >> 3) + (x >> 3)) << 6;
+  x &= 7;
+  y &= 7;
+  return tile + ((x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3));
+}
+
+// Rasterizes the alpha of a blurred rounded rectangle, inset by the blur amount, in a square A8 texture.
+//
+// The texture is symmetric on both axes, so that its vertical orientation does not matter, and its
+// center rows and columns are uniform, so that it can be stretched as a nine-slice.
+static inline bool Clay3DSi__RasterizeShadow(Clay3DSi__ShadowEntry* entry, u16 radius, u16 blur)
+{
+  u16 corner = radius + 2 * blur;
+  u16 size = 8;
+  while (size < 2 * corner + 2)
+  {
+    size <<= 1;
+  }
+
+  if (!C3D_TexInit(&entry->tex, size, size, GPU_A8))
+  {
+    return false;
+  }
+
+  float half = size / 2.f - blur;
+  float sigma = blur / 2.f;
+  u8* data = (u8*)entry->tex.data;
+
+  for (u32 y = 0; y < size; ++y)
+  {
+    for (u32 x = 0; x < size; ++x)
+    {
+      // Signed distance from the rounded rectangle, negative inside of it.
+      float qx = fabsf(x + 0.5f - size / 2.f) - (half - radius);
+      float qy = fabsf(y + 0.5f - size / 2.f) - (half - radius);
+      float ox = qx > 0.f ? qx : 0.f;
+      float oy = qy > 0.f ? qy : 0.f;
+      float distance = sqrtf(ox * ox + oy * oy) + Clay3DSi__MIN(qx > qy ? qx : qy, 0.f) - radius;
+
+      float alpha = blur > 0 ? 0.5f * erfcf(distance / (sigma * (float)M_SQRT2)) : 0.5f - distance;
+      alpha = alpha < 0.f ? 0.f : (alpha > 1.f ? 1.f : alpha);
+      data[Clay3DSi__TexelOffset(x, y, size)] = (u8)(alpha * 255.f + 0.5f);
+    }
+  }
+
+  C3D_TexFlush(&entry->tex);
+  C3D_TexSetFilter(&entry->tex, GPU_LINEAR, GPU_LINEAR);
+  C3D_TexSetWrap(&entry->tex, GPU_CLAMP_TO_EDGE, GPU_CLAMP_TO_EDGE);
+
+  entry->radius = radius;
+  entry->blur = blur;
+  entry->corner = corner;
+  entry->valid = true;
+  return true;
+}
+
+// Returns the cached texture for the specified shadow parameters, rasterizing it if needed.
+//
+// @return The cache entry, or NULL if every entry has been drawn in the current or in the previous frame.
+static inline Clay3DSi__ShadowEntry* Clay3DSi__GetShadow(u16 radius, u16 blur)
+{
+  Clay3DSi__ShadowEntry* victim = NULL;
+
+  for (u32 i = 0; i < Clay3DSi__MAX_SHADOWS; ++i)
+  {
+    Clay3DSi__ShadowEntry* entry = &Clay3DSi__shadowCache[i];
+    if (entry->valid && entry->radius == radius && entry->blur == blur)
+    {
+      entry->lastUsed = Clay3DSi__shadowFrame;
+      return entry;
+    }
+
+    // Prefer empty entries, then the least recently used one.
+    if (!entry->valid)
+    {
+      if (victim == NULL || victim->valid)
+      {
+        victim = entry;
+      }
+    }
+    else if (entry->lastUsed + 1 < Clay3DSi__shadowFrame && (victim == NULL || (victim->valid && entry->lastUsed < victim->lastUsed)))
+    {
+      victim = entry;
+    }
+  }
+
+  if (victim == NULL)
+  {
+    if (Clay3DSi__shadowMisses++ == 0)
+    {
+      fprintf(stderr, "error: shadow cache is full (%d textures in use), %s\n", Clay3DSi__MAX_SHADOWS,
+              Clay3DSi__shadowFrame == 0 ? "Clay3DS_ShadowCacheUpdate was never called" : "shadows are being dropped");
+    }
+    return NULL;
+  }
+
+  if (victim->valid)
+  {
+    C3D_TexDelete(&victim->tex);
+    victim->valid = false;
+  }
+
+  if (!Clay3DSi__RasterizeShadow(victim, radius, blur))
+  {
+    return NULL;
+  }
+
+  victim->lastUsed = Clay3DSi__shadowFrame;
+  return victim;
+}
+
+// Draws the shadow for an element with the specified bounding box, as a nine-slice of a cached texture.
+static inline void Clay3DS_DrawShadow(Clay_BoundingBox box, const Clay3DS_Shadow* shadow)
+{
+  // Parameters are rounded to whole pixels, so that nearly identical shadows share the same texture.
+  // The texture side must fit the corner slices (radius + 2 * blur each) and two center texels.
+  float blur = Clay3DSi__MIN(Clay3DSi__MAX(shadow->blur, 0.f) + 0.5f, (Clay3DSi__MAX_SHADOW_SIZE - 2) / 4);
+  float maxRadius = Clay3DSi__MIN(Clay3DSi__MIN(box.width, box.height) / 2.f, (Clay3DSi__MAX_SHADOW_SIZE - 2) / 2 - 2 * (u16)blur);
+  float radius = Clay3DSi__MIN(Clay3DSi__MAX(shadow->cornerRadius, 0.f) + 0.5f, Clay3DSi__MAX(maxRadius, 0.f));
+
+  Clay3DSi__ShadowEntry* entry = Clay3DSi__GetShadow((u16)radius, (u16)blur);
+  if (entry == NULL || !Clay3DSi__ReserveGeometry(0, 9))
+  {
+    return;
+  }
+
+  // Source slice edges, in texels, and destination slice edges, in pixels.
+  float size = entry->tex.width;
+  float src[4] = {0.f, entry->corner, size - entry->corner, size};
+  float dx[4], dy[4];
+  float width = box.width + 2.f * entry->blur;
+  float height = box.height + 2.f * entry->blur;
+  float cw = Clay3DSi__MIN((float)entry->corner, width / 2.f);
+  float ch = Clay3DSi__MIN((float)entry->corner, height / 2.f);
+
+  dx[0] = box.x + shadow->offset.x - entry->blur;
+  dx[1] = dx[0] + cw;
+  dx[3] = dx[0] + width;
+  dx[2] = dx[3] - cw;
+  dy[0] = box.y + shadow->offset.y - entry->blur;
+  dy[1] = dy[0] + ch;
+  dy[3] = dy[0] + height;
+  dy[2] = dy[3] - ch;
+
+  C2D_ImageTint tint;
+  C2D_PlainImageTint(&tint, Clay3DSi__CLAY_COLOR_TO_C2D(shadow->color), 1.f);
+
+  for (u32 row = 0; row < 3; ++row)
+  {
+    for (u32 col = 0; col < 3; ++col)
+    {
+      float w = dx[col + 1] - dx[col];
+      float h = dy[row + 1] - dy[row];
+      if (w <= 0.f || h <= 0.f)
+      {
+        continue;
+      }
+
+      // clang-format off
+      Tex3DS_SubTexture subtex = {
+        (u16)(src[col + 1] - src[col]), (u16)(src[row + 1] - src[row]),
+        src[col] / size, 1.f - src[row] / size, src[col + 1] / size, 1.f - src[row + 1] / size,
+      };
+      // clang-format on
+
+      C2D_Image image = {&entry->tex, &subtex};
+      C2D_DrawParams params = {{dx[col], dy[row], w, h}, {0.f, 0.f}, 0.f, 0.f};
+      C2D_DrawImage(image, &params, &tint);
+    }
+  }
+}
+
+// Custom draw function that renders the Clay3DS_Shadow used as customData in the element's bounding box.
+static inline void Clay3DS_ShadowHandler(Clay_RenderCommand* command, void* userData)
+{
+  (void)userData;
+  Clay3DS_DrawShadow(command->boundingBox, (const Clay3DS_Shadow*)command->config.customElementConfig->customData);
+}
+
+typedef struct
+{
+  C3D_RenderTarget* target;
+  Clay_Dimensions dimensions;
+  // Position of the target's origin in layout space, which is not zero while rendering a cached layer.
+  float originX;
+  float originY;
+  bool isLayer;
+  // Nested clip rectangles, each one already intersected with its parent.
+  Clay_BoundingBox clipStack[Clay3DSi__MAX_CLIP_DEPTH];
+  u32 clipDepth;
+  // Scissor that is currently applied to the GPU, which can be wider than the clip rectangle.
+  bool scissorActive;
+  Clay_BoundingBox scissorBox;
+} Clay3DSi__RenderState;
+
+enum
+{
+  Clay3DSi__CLIP_INSIDE = 0,
+  Clay3DSi__CLIP_PARTIAL = 1,
+  Clay3DSi__CLIP_OUTSIDE = 2,
+};
+
+static inline void Clay3DSi__InitRenderState(Clay3DSi__RenderState* state, C3D_RenderTarget* target, Clay_Dimensions dimensions,
+                                             float originX, float originY, bool isLayer)
+{
+  memset(state, 0, sizeof(*state));
+  state->target = target;
+  state->dimensions = dimensions;
+  state->originX = originX;
+  state->originY = originY;
+  state->isLayer = isLayer;
+}
+
+static inline Clay_BoundingBox Clay3DSi__Intersect(Clay_BoundingBox a, Clay_BoundingBox b)
+{
+  float x1 = Clay3DSi__MAX(a.x, b.x);
+  float y1 = Clay3DSi__MAX(a.y, b.y);
+  float x2 = Clay3DSi__MIN(a.x + a.width, b.x + b.width);
+  float y2 = Clay3DSi__MIN(a.y + a.height, b.y + b.height);
+  return (Clay_BoundingBox){x1, y1, Clay3DSi__MAX(x2 - x1, 0.f), Clay3DSi__MAX(y2 - y1, 0.f)};
+}
+
+// Returns the box grown by the specified amount on every side.
+static inline Clay_BoundingBox Clay3DSi__Grow(Clay_BoundingBox box, float amount)
+{
+  return (Clay_BoundingBox){box.x - amount, box.y - amount, box.width + 2.f * amount, box.height + 2.f * amount};
+}
+
+static inline bool Clay3DSi__Contains(Clay_BoundingBox outer, Clay_BoundingBox inner)
+{
+  return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width &&
+         inner.y + inner.height <= outer.y + outer.height;
+}
+
+static inline Clay_BoundingBox Clay3DSi__GetClip(Clay3DSi__RenderState* state)
+{
+  return state->clipStack[Clay3DSi__MIN(state->clipDepth, Clay3DSi__MAX_CLIP_DEPTH) - 1];
+}
+
+static inline void Clay3DSi__PushClip(Clay3DSi__RenderState* state, Clay_BoundingBox box)
+{
+  if (state->clipDepth > 0)
+  {
+    box = Clay3DSi__Intersect(Clay3DSi__GetClip(state), box);
+  }
+
+  // When the stack is full, the deepest rectangle keeps getting narrowed. Popping it will then over-clip, which is
+  // still better than drawing outside of the containers.
+  state->clipStack[Clay3DSi__MIN(state->clipDepth, Clay3DSi__MAX_CLIP_DEPTH - 1)] = box;
+  state->clipDepth++;
+}
+
+static inline void Clay3DSi__PopClip(Clay3DSi__RenderState* state)
+{
+  if (state->clipDepth > 0)
+  {
+    state->clipDepth--;
+  }
+}
+
+static inline u32 Clay3DSi__ClassifyClip(Clay3DSi__RenderState* state, Clay_BoundingBox box)
+{
+  if (state->clipDepth == 0)
+  {
+    return Clay3DSi__CLIP_INSIDE;
+  }
+
+  Clay_BoundingBox clip = Clay3DSi__GetClip(state);
+  Clay_BoundingBox visible = Clay3DSi__Intersect(clip, box);
+  if (visible.width <= 0.f || visible.height <= 0.f)
+  {
+    return Clay3DSi__CLIP_OUTSIDE;
+  }
+
+  return Clay3DSi__Contains(clip, box) ? Clay3DSi__CLIP_INSIDE : Clay3DSi__CLIP_PARTIAL;
+}
+
+// Changes the GPU scissor. This flushes the geometry drawn with the previous one, so it should be done only when needed.
+static inline void Clay3DSi__SetScissor(Clay3DSi__RenderState* state, bool active, Clay_BoundingBox box)
+{
+  C2D_Flush();
+
+  state->scissorActive = active;
+  state->scissorBox = box;
+
+  if (!active)
+  {
+    C3D_SetScissor(GPU_SCISSOR_DISABLE, 0, 0, 0, 0);
+    return;
+  }
+
+  box.x -= state->originX;
+  box.y -= state->originY;
+
+  if (state->isLayer)
+  {
+    // Layer textures are not rotated like the screen framebuffers, but their rows are stored from the bottom up.
+    float height = state->dimensions.height;
+    C3D_SetScissor(GPU_SCISSOR_NORMAL, box.x, height - box.y - box.height, box.x + box.width, height - box.y);
+  }
+  else
+  {
+    // clang-format off
+    C3D_SetScissor(GPU_SCISSOR_NORMAL,
+                   state->dimensions.height - box.height - box.y,
+                   state->dimensions.width - box.width - box.x,
+                   box.height + box.y,
+                   state->dimensions.width - box.x);
+    // clang-format on
+  }
+}
+
+// Prepares the GPU scissor for geometry, with the specified bounds, that was not clipped on the CPU.
+// The hardware scissor is only enabled when the geometry crosses the clip rectangle.
+//
+// @return False if the geometry is completely clipped, and should not be drawn.
+static inline bool Clay3DSi__BeginGeometry(Clay3DSi__RenderState* state, Clay_BoundingBox bounds)
+{
+  switch (Clay3DSi__ClassifyClip(state, bounds))
+  {
+  case Clay3DSi__CLIP_OUTSIDE:
+    return false;
+  case Clay3DSi__CLIP_PARTIAL: {
+    Clay_BoundingBox clip = Clay3DSi__GetClip(state);
+    if (!state->scissorActive || memcmp(&state->scissorBox, &clip, sizeof(clip)) != 0)
+    {
+      Clay3DSi__SetScissor(state, true, clip);
+    }
+    return true;
+  }
+  default:
+    // The geometry needs no clipping, but an older, smaller, scissor could still cut it.
+    if (state->scissorActive && !Clay3DSi__Contains(state->scissorBox, bounds))
+    {
+      Clay3DSi__SetScissor(state, false, bounds);
+    }
+    return true;
+  }
+}
+
+// Prepares the GPU scissor for geometry whose bounds are unknown, so it is always cut to the clip rectangle.
+//
+// @return False if the clip rectangle is empty, and nothing should be drawn.
+static inline bool Clay3DSi__BeginUnboundedGeometry(Clay3DSi__RenderState* state)
+{
+  if (state->clipDepth == 0)
+  {
+    if (state->scissorActive)
+    {
+      Clay3DSi__SetScissor(state, false, state->scissorBox);
+    }
+    return true;
+  }
+
+  Clay_BoundingBox clip = Clay3DSi__GetClip(state);
+  if (clip.width <= 0.f || clip.height <= 0.f)
+  {
+    return false;
+  }
+
+  if (!state->scissorActive || memcmp(&state->scissorBox, &clip, sizeof(clip)) != 0)
+  {
+    Clay3DSi__SetScissor(state, true, clip);
+  }
+  return true;
+}
+
+// Returns the half width of the anti-aliasing fringe of an edge at the specified coordinate, which is zero for the
+// edges aligned to the pixel grid, as they are already sharp.
+static inline float Clay3DSi__EdgeFringe(float coordinate)
+{
+  return (float)(s32)coordinate == coordinate ? 0.f : Clay3DSi__FRINGE_HALF_WIDTH;
+}
+
+// Draws a solid rectangle, fading each edge over a fringe with the specified half width (left, top, right and
+// bottom), or leaving it sharp if that is zero.
+static inline void Clay3DSi__FillRectAntialiased(Clay_BoundingBox box, float l, float t, float r, float b, u32 color)
+{
+  float x1 = box.x;
+  float y1 = box.y;
+  float x2 = x1 + box.width;
+  float y2 = y1 + box.height;
+
+  if (l <= 0.f && t <= 0.f && r <= 0.f && b <= 0.f)
+  {
+    if (Clay3DSi__ReserveGeometry(0, 1))
+    {
+      C2D_DrawRectSolid(box.x, box.y, 0.f, box.width, box.height, color);
+    }
+    return;
+  }
+
+  u32 edges = (l > 0.f) + (t > 0.f) + (r > 0.f) + (b > 0.f);
+  if (!Clay3DSi__ReserveGeometry(2 + 2 * edges, 0))
+  {
+    return;
+  }
+
+  // The fringes are mitered at the corners, so that they fade towards the outer corners of the rectangle.
+  Clay3DSi__FillQuad(x1 + l, y1 + t, x2 - r, y1 + t, x2 - r, y2 - b, x1 + l, y2 - b, color);
+  if (t > 0.f)
+  {
+    Clay3DSi__FillFringeQuad(x1 + l, y1 + t, x2 - r, y1 + t, x2 + r, y1 - t, x1 - l, y1 - t, color);
+  }
+  if (r > 0.f)
+  {
+    Clay3DSi__FillFringeQuad(x2 - r, y1 + t, x2 - r, y2 - b, x2 + r, y2 + b, x2 + r, y1 - t, color);
+  }
+  if (b > 0.f)
+  {
+    Clay3DSi__FillFringeQuad(x2 - r, y2 - b, x1 + l, y2 - b, x1 - l, y2 + b, x2 + r, y2 + b, color);
+  }
+  if (l > 0.f)
+  {
+    Clay3DSi__FillFringeQuad(x1 + l, y2 - b, x1 + l, y1 + t, x1 - l, y1 - t, x1 - l, y2 + b, color);
+  }
+}
+
+// Draws a solid rectangle, trimmed to the clip rectangle on the CPU.
+static inline void Clay3DSi__FillRect(Clay3DSi__RenderState* state, float x, float y, float width, float height, u32 color)
+{
+  Clay_BoundingBox box = {x, y, width, height};
+  Clay_BoundingBox clip = box;
+  if (state->clipDepth > 0)
+  {
+    clip = Clay3DSi__GetClip(state);
+    box = Clay3DSi__Intersect(clip, box);
+  }
+
+  if (box.width <= 0.f || box.height <= 0.f)
+  {
+    return;
+  }
+
+  // Edges that are not aligned to the pixel grid are faded, except for the ones cut by the clip rectangle, whose
+  // fringe would reach out of it.
+  float l = 0.f, t = 0.f, r = 0.f, b = 0.f;
+  if (Clay3DSi__IsAntialiased() && box.width >= 1.f && box.height >= 1.f)
+  {
+    l = x < clip.x ? 0.f : Clay3DSi__EdgeFringe(box.x);
+    t = y < clip.y ? 0.f : Clay3DSi__EdgeFringe(box.y);
+    r = x + width > clip.x + clip.width ? 0.f : Clay3DSi__EdgeFringe(box.x + box.width);
+    b = y + height > clip.y + clip.height ? 0.f : Clay3DSi__EdgeFringe(box.y + box.height);
+  }
+
+  Clay_BoundingBox bounds = {box.x - l, box.y - t, box.width + l + r, box.height + t + b};
+  if (Clay3DSi__BeginGeometry(state, bounds))
+  {
+    Clay3DSi__FillRectAntialiased(box, l, t, r, b, color);
+  }
+}
+
+// Draws an image stretched to the specified box, trimming its position and texture coordinates to the clip
+// rectangle on the CPU. Rotated subtextures fall back to the hardware scissor.
+static inline void Clay3DSi__DrawImage(Clay3DSi__RenderState* state, C2D_Image image, Clay_BoundingBox box, const C2D_ImageTint* tint)
+{
+  u32 clip = Clay3DSi__ClassifyClip(state, box);
+  if (clip == Clay3DSi__CLIP_OUTSIDE)
+  {
+    return;
+  }
+
+  Tex3DS_SubTexture trimmed;
+  const Tex3DS_SubTexture* subtex = image.subtex;
+  bool isRotated = subtex->top < subtex->bottom;
+
+  if (clip == Clay3DSi__CLIP_PARTIAL && !isRotated && box.width > 0.f && box.height > 0.f)
+  {
+    Clay_BoundingBox visible = Clay3DSi__Intersect(Clay3DSi__GetClip(state), box);
+    float u1 = (visible.x - box.x) / box.width;
+    float u2 = (visible.x + visible.width - box.x) / box.width;
+    float v1 = (visible.y - box.y) / box.height;
+    float v2 = (visible.y + visible.height - box.y) / box.height;
+
+    trimmed.width = (u16)(subtex->width * (u2 - u1));
+    trimmed.height = (u16)(subtex->height * (v2 - v1));
+    trimmed.left = subtex->left + (subtex->right - subtex->left) * u1;
+    trimmed.right = subtex->left + (subtex->right - subtex->left) * u2;
+    trimmed.top = subtex->top + (subtex->bottom - subtex->top) * v1;
+    trimmed.bottom = subtex->top + (subtex->bottom - subtex->top) * v2;
+
+    image.subtex = &trimmed;
+    box = visible;
+  }
+
+  if (Clay3DSi__BeginGeometry(state, box) && Clay3DSi__ReserveGeometry(0, 1))
+  {
+    C2D_DrawParams params = {{box.x, box.y, box.width, box.height}, {0.f, 0.f}, 0.f, 0.f};
+    C2D_DrawImage(image, &params, tint);
+  }
+}
+
+// Draws text that crosses the clip rectangle. citro2d generates the quads of whole strings, so the glyphs are laid
+// out here instead, and each one is culled or trimmed to the clip rectangle on the CPU like an image.
+static inline void Clay3DSi__DrawClippedText(Clay3DSi__RenderState* state, C2D_Font font, const char* string, Clay_BoundingBox box,
+                                             float scale, u32 color)
+{
+  C2D_ImageTint tint;
+  C2D_PlainImageTint(&tint, color, 1.f);
+  float lineFeed = scale * C2D_FontGetInfo(font)->lineFeed;
+  float x = box.x;
+  float y = box.y;
+
+  const u8* p = (const u8*)string;
+  while (*p != '\0')
+  {
+    u32 codepoint;
+    ssize_t units = decode_utf8(&codepoint, p);
+    if (units <= 0)
+    {
+      codepoint = 0xFFFD;
+      units = 1;
+    }
+    p += units;
+
+    if (codepoint == '\n')
+    {
+      x = box.x;
+      y += lineFeed;
+      continue;
+    }
+
+    fontGlyphPos_s glyph;
+    C2D_FontCalcGlyphPos(font, &glyph, C2D_FontGlyphIndexFromCodePoint(font, codepoint), GLYPH_POS_CALC_VTXCOORD, scale, scale);
+
+    Clay_BoundingBox glyphBox = {x + glyph.vtx.left, y + glyph.vtx.top, glyph.vtx.right - glyph.vtx.left, glyph.vtx.bottom - glyph.vtx.top};
+    // clang-format off
+    Tex3DS_SubTexture subtex = {
+      (u16)glyphBox.width, (u16)glyphBox.height,
+      glyph.texcoord.left, glyph.texcoord.top, glyph.texcoord.right, glyph.texcoord.bottom,
+    };
+    // clang-format on
+
+    C2D_Image image = {C2D_FontGetSheet(font, glyph.sheetIndex), &subtex};
+    Clay3DSi__DrawImage(state, image, glyphBox, &tint);
+    x += glyph.xAdvance;
+  }
+}
+
+typedef struct
+{
+  // Number of draws of images that were resident.
+  u32 hits;
+  // Number of draws of images that were not resident, and were replaced by the placeholder.
+  u32 misses;
+  // Number of images that were loaded, and evicted to stay under the budget.
+  u32 loads;
+  u32 evictions;
+  u32 residentBytes;
+  // Average time, in milliseconds, from the first draw of an image to it being resident.
+  float averageLatency;
+} Clay3DS_ImageCacheStats;
+
+enum
+{
+  Clay3DSi__IMAGE_UNLOADED = 0,
+  Clay3DSi__IMAGE_QUEUED,
+  Clay3DSi__IMAGE_LOADING,
+  Clay3DSi__IMAGE_READ,
+  Clay3DSi__IMAGE_RESIDENT,
+  Clay3DSi__IMAGE_FAILED,
+};
+
+typedef struct
+{
+  char path[Clay3DSi__MAX_IMAGE_PATH];
+  u32 state;
+  // Contents of the file, read by the worker thread and imported by the main thread.
+  void* fileData;
+  size_t fileSize;
+  Tex3DS_Texture texture;
+  C3D_Tex tex;
+  C2D_Image image;
+  u32 lastUsed;
+  u64 requestTime;
+} Clay3DSi__CachedImage;
+
+static Clay3DSi__CachedImage Clay3DSi__images[Clay3DSi__MAX_CACHED_IMAGES];
+static u16 Clay3DSi__numImages = 0;
+static u32 Clay3DSi__imageBudget = 0;
+// Number of rendered frames, which is only advanced by the updates that follow a Clay3DS_Render call.
+static u32 Clay3DSi__imageFrame = 0;
+static bool Clay3DSi__imageRendered = false;
+// Set by the worker thread when it fails to read an image, so that the next update reports it.
+static bool Clay3DSi__imageFailed = false;
+static u32 Clay3DSi__imagePlaceholder = 0;
+static u64 Clay3DSi__imageLatency = 0;
+static Clay3DS_ImageCacheStats Clay3DSi__imageStats;
+static LightLock Clay3DSi__imageLock;
+static LightEvent Clay3DSi__imageEvent;
+static Thread Clay3DSi__imageWorker = NULL;
+static volatile bool Clay3DSi__imageWorkerExit = false;
+
+// Returns the state of the image. It is read with the lock held, as the worker thread changes it while loading.
+static inline u32 Clay3DSi__GetImageState(Clay3DSi__CachedImage* image)
+{
+  LightLock_Lock(&Clay3DSi__imageLock);
+  u32 state = image->state;
+  LightLock_Unlock(&Clay3DSi__imageLock);
+  return state;
+}
+
+static inline void Clay3DSi__SetImageState(Clay3DSi__CachedImage* image, u32 state)
+{
+  LightLock_Lock(&Clay3DSi__imageLock);
+  image->state = state;
+  LightLock_Unlock(&Clay3DSi__imageLock);
+}
+
+static inline void Clay3DSi__ImageWorkerMain(void* arg)
+{
+  (void)arg;
+
+  while (!Clay3DSi__imageWorkerExit)
+  {
+    Clay3DSi__CachedImage* image = NULL;
+
+    LightLock_Lock(&Clay3DSi__imageLock);
+    for (u16 i = 0; i < Clay3DSi__numImages && image == NULL; ++i)
+    {
+      if (Clay3DSi__images[i].state == Clay3DSi__IMAGE_QUEUED)
+      {
+        image = &Clay3DSi__images[i];
+        image->state = Clay3DSi__IMAGE_LOADING;
+      }
+    }
+    LightLock_Unlock(&Clay3DSi__imageLock);
+
+    if (image == NULL)
+    {
+      LightEvent_Wait(&Clay3DSi__imageEvent);
+      continue;
+    }
+
+    void* data = NULL;
+    size_t size = 0;
+    FILE* file = fopen(image->path, "rb");
+    if (file != NULL)
+    {
+      fseek(file, 0, SEEK_END);
+      long length = ftell(file);
+      fseek(file, 0, SEEK_SET);
+
+      data = length > 0 ? malloc(length) : NULL;
+      if (data != NULL && fread(data, 1, length, file) == (size_t)length)
+      {
+        size = length;
+      }
+      else
+      {
+        free(data);
+        data = NULL;
+      }
+      fclose(file);
+    }
+
+    LightLock_Lock(&Clay3DSi__imageLock);
+    image->fileData = data;
+    image->fileSize = size;
+    image->state = data != NULL ? Clay3DSi__IMAGE_READ : Clay3DSi__IMAGE_FAILED;
+    Clay3DSi__imageFailed |= data == NULL;
+    LightLock_Unlock(&Clay3DSi__imageLock);
+  }
+}
+
+// Initializes the image cache, starting the thread that loads the images in the background.
+//
+// @param budget Maximum number of bytes of texture memory used by the resident images.
+// @return True if successful, or false if the worker thread could not be created.
+static inline bool Clay3DS_ImageCacheInit(u32 budget)
+{
+  if (Clay3DSi__imageWorker != NULL)
+  {
+    Clay3DSi__imageBudget = budget;
+    return true;
+  }
+
+  Clay3DSi__imageBudget = budget;
+  Clay3DSi__imagePlaceholder = C2D_Color32(128, 128, 128, 64);
+  Clay3DSi__imageWorkerExit = false;
+  LightLock_Init(&Clay3DSi__imageLock);
+  LightEvent_Init(&Clay3DSi__imageEvent, RESET_ONESHOT);
+
+  // Run at a lower priority than the main thread, so that loading never delays the frames.
+  s32 priority = 0x30;
+  svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+  Clay3DSi__imageWorker = threadCreate(Clay3DSi__ImageWorkerMain, NULL, Clay3DSi__IMAGE_WORKER_STACK_SIZE,
+                                       Clay3DSi__MIN(priority + 1, 0x3F), -2, false);
+  return Clay3DSi__imageWorker != NULL;
+}
+
+static inline void Clay3DSi__UnloadImage(Clay3DSi__CachedImage* image)
+{
+  if (Clay3DSi__GetImageState(image) == Clay3DSi__IMAGE_RESIDENT)
+  {
+    Clay3DSi__imageStats.residentBytes -= image->tex.size;
+    Tex3DS_TextureFree(image->texture);
+    C3D_TexDelete(&image->tex);
+  }
+
+  free(image->fileData);
+  image->fileData = NULL;
+  Clay3DSi__SetImageState(image, Clay3DSi__IMAGE_UNLOADED);
+}
+
+// Stops the worker thread and releases all the images. The handles returned by Clay3DS_CachedImage become invalid.
+static inline void Clay3DS_ImageCacheExit(void)
+{
+  if (Clay3DSi__imageWorker == NULL)
+  {
+    return;
+  }
+
+  Clay3DSi__imageWorkerExit = true;
+  LightEvent_Signal(&Clay3DSi__imageEvent);
+  threadJoin(Clay3DSi__imageWorker, U64_MAX);
+  threadFree(Clay3DSi__imageWorker);
+  Clay3DSi__imageWorker = NULL;
+
+  for (u16 i = 0; i < Clay3DSi__numImages; ++i)
+  {
+    Clay3DSi__UnloadImage(&Clay3DSi__images[i]);
+  }
+  Clay3DSi__numImages = 0;
+}
+
+// Returns the handle of the Tex3DS (.t3x) image at the specified path (for example "romfs:/gfx/icon.t3x"),
+// to be used as the imageData of an image element. The image is loaded in the background the first time it is
+// drawn, and a placeholder is drawn until it is ready.
+//
+// @return The image handle, or NULL if the maximum number of cached images has been reached.
+static inline void* Clay3DS_CachedImage(const char* path)
+{
+  for (u16 i = 0; i < Clay3DSi__numImages; ++i)
+  {
+    if (strcmp(Clay3DSi__images[i].path, path) == 0)
+    {
+      return &Clay3DSi__images[i];
+    }
+  }
+
+  if (Clay3DSi__numImages >= Clay3DSi__MAX_CACHED_IMAGES || strlen(path) >= Clay3DSi__MAX_IMAGE_PATH)
+  {
+    return NULL;
+  }
+
+  // The worker only reads the slots below numImages, so the new slot is ready before it is published.
+  Clay3DSi__CachedImage* image = &Clay3DSi__images[Clay3DSi__numImages];
+  memset(image, 0, sizeof(*image));
+  strcpy(image->path, path);
+
+  LightLock_Lock(&Clay3DSi__imageLock);
+  Clay3DSi__numImages++;
+  LightLock_Unlock(&Clay3DSi__imageLock);
+  return image;
+}
+
+// Sets the color drawn in place of the images that are still loading.
+static inline void Clay3DS_ImageCacheSetPlaceholder(Clay_Color color)
+{
+  Clay3DSi__imagePlaceholder = Clay3DSi__CLAY_COLOR_TO_C2D(color);
+}
+
+// Uploads the images loaded by the worker thread, and evicts the least recently drawn ones while over budget.
+//
+// This function should be executed on every iteration of the main loop (once per vblank), before C3D_FrameBegin
+// has been called, including the iterations that a Clay3DS_FrameDriver skips, otherwise loading stops while idle.
+//
+// @return True if an image became resident or failed to load, so that the screens that show it must be drawn
+//         again (for example with Clay3DS_FrameDriverInvalidate), or they would keep showing the placeholder.
+static inline bool Clay3DS_ImageCacheUpdate(void)
+{
+  if (Clay3DSi__imageRendered)
+  {
+    Clay3DSi__imageFrame++;
+    Clay3DSi__imageRendered = false;
+  }
+
+  LightLock_Lock(&Clay3DSi__imageLock);
+  bool isChanged = Clay3DSi__imageFailed;
+  Clay3DSi__imageFailed = false;
+  LightLock_Unlock(&Clay3DSi__imageLock);
+
+  u32 uploads = 0;
+  for (u16 i = 0; i < Clay3DSi__numImages && uploads < Clay3DSi__MAX_IMAGE_UPLOADS; ++i)
+  {
+    Clay3DSi__CachedImage* image = &Clay3DSi__images[i];
+
+    if (Clay3DSi__GetImageState(image) != Clay3DSi__IMAGE_READ)
+    {
+      continue;
+    }
+
+    // Tex3DS files are already swizzled, so they are copied straight to VRAM.
+    image->texture = Tex3DS_TextureImport(image->fileData, image->fileSize, &image->tex, NULL, true);
+    free(image->fileData);
+    image->fileData = NULL;
+    uploads++;
+
+    if (image->texture == NULL)
+    {
+      Clay3DSi__SetImageState(image, Clay3DSi__IMAGE_FAILED);
+      continue;
+    }
+
+    C3D_TexSetFilter(&image->tex, GPU_LINEAR, GPU_LINEAR);
+    image->image = (C2D_Image){&image->tex, Tex3DS_GetSubTexture(image->texture, 0)};
+    Clay3DSi__SetImageState(image, Clay3DSi__IMAGE_RESIDENT);
+
+    Clay3DSi__imageStats.loads++;
+    Clay3DSi__imageStats.residentBytes += image->tex.size;
+    Clay3DSi__imageLatency += osGetTime() - image->requestTime;
+    Clay3DSi__imageStats.averageLatency = (float)Clay3DSi__imageLatency / Clay3DSi__imageStats.loads;
+  }
+
+  while (Clay3DSi__imageStats.residentBytes > Clay3DSi__imageBudget)
+  {
+    // Images drawn in the previous rendered frame could still be read by the GPU, so they are never evicted.
+    Clay3DSi__CachedImage* victim = NULL;
+    for (u16 i = 0; i < Clay3DSi__numImages; ++i)
+    {
+      Clay3DSi__CachedImage* image = &Clay3DSi__images[i];
+      if (Clay3DSi__GetImageState(image) == Clay3DSi__IMAGE_RESIDENT && image->lastUsed + 1 < Clay3DSi__imageFrame &&
+          (victim == NULL || image->lastUsed < victim->lastUsed))
+      {
+        victim = image;
+      }
+    }
+
+    if (victim == NULL)
+    {
+      break;
+    }
+
+    Clay3DSi__UnloadImage(victim);
+    Clay3DSi__imageStats.evictions++;
+  }
+
+  return isChanged || uploads > 0;
+}
+
+// Returns the statistics of the image cache.
+static inline Clay3DS_ImageCacheStats Clay3DS_GetImageCacheStats(void)
+{
+  return Clay3DSi__imageStats;
+}
+
+static inline bool Clay3DSi__IsCachedImage(void* imageData)
+{
+  return (u8*)imageData >= (u8*)Clay3DSi__images && (u8*)imageData < (u8*)(Clay3DSi__images + Clay3DSi__MAX_CACHED_IMAGES);
+}
+
+static inline void Clay3DSi__DrawCachedImage(Clay3DSi__RenderState* state, Clay3DSi__CachedImage* image, Clay_BoundingBox box)
+{
+  image->lastUsed = Clay3DSi__imageFrame;
+  u32 imageState = Clay3DSi__GetImageState(image);
+
+  if (imageState == Clay3DSi__IMAGE_RESIDENT)
+  {
+    Clay3DSi__imageStats.hits++;
+    Clay3DSi__DrawImage(state, image->image, box, NULL);
+    return;
+  }
+
+  if (imageState == Clay3DSi__IMAGE_UNLOADED && Clay3DSi__imageWorker != NULL)
+  {
+    LightLock_Lock(&Clay3DSi__imageLock);
+    image->state = Clay3DSi__IMAGE_QUEUED;
+    image->requestTime = osGetTime();
+    LightLock_Unlock(&Clay3DSi__imageLock);
+    LightEvent_Signal(&Clay3DSi__imageEvent);
+  }
+
+  Clay3DSi__imageStats.misses++;
+  Clay3DSi__FillRect(state, box.x, box.y, box.width, box.height, Clay3DSi__imagePlaceholder);
+}
+
+static inline void Clay3DSi__RenderCommand(Clay3DSi__RenderState* state, Clay_RenderCommand* renderCommand)
+{
+  Clay_BoundingBox box = renderCommand->boundingBox;
+
+  switch (renderCommand->commandType)
+  {
+  case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
+    Clay_RectangleElementConfig* config = renderCommand->config.rectangleElementConfig;
+    u32 color = Clay3DSi__CLAY_COLOR_TO_C2D(config->color);
+    float tlr = config->cornerRadius.topLeft;
+    float trr = config->cornerRadius.topRight;
+    float brr = config->cornerRadius.bottomRight;
+    float blr = config->cornerRadius.bottomLeft;
+    // The anti-aliasing fringe reaches out of the box, so it is part of the bounds checked against the clip rectangle.
+    Clay_BoundingBox bounds = Clay3DSi__Grow(box, Clay3DSi__IsAntialiased() ? Clay3DSi__FRINGE_HALF_WIDTH : 0.f);
+
+    if (!Clay3DSi__HAS_ROUNDED_CORNERS || (tlr <= 0.f && trr <= 0.f && brr <= 0.f && blr <= 0.f))
+    {
+      // If no rounding is used, fall back to the faster, simpler, rectangle drawing.
+      Clay3DSi__FillRect(state, box.x, box.y, box.width, box.height, color);
+    }
+    else if (Clay3DSi__BeginGeometry(state, bounds))
+    {
+      // Make sure that the rounding is not bigger than half of any side.
+      float max = Clay3DSi__MIN(box.width, box.height) / 2.f;
+      tlr = Clay3DSi__MIN(tlr, max);
+      trr = Clay3DSi__MIN(trr, max);
+      brr = Clay3DSi__MIN(brr, max);
+      blr = Clay3DSi__MIN(blr, max);
+
+      // Shapes thinner than the fringe are left aliased, as the fringe would cover them entirely.
+      float fringe = Clay3DSi__IsAntialiased() && max >= Clay3DSi__FRINGE_HALF_WIDTH ? Clay3DSi__FRINGE_HALF_WIDTH : 0.f;
+      u32 triangles = Clay3DSi__RECT_TRIANGLES + (fringe > 0.f ? Clay3DSi__FRINGE_TRIANGLES : 0);
+
+      if (Clay3DSi__ReserveGeometry(triangles, 0))
+      {
+        Clay3DSi__FillRoundedRect(box, tlr, trr, brr, blr, fringe, color);
+      }
+      else if (Clay3DSi__ReserveGeometry(0, 1))
+      {
+        // Out of space for the corners, but a plain rectangle still fits.
+        Clay3DSi__vertexStats.degraded++;
+        C2D_DrawRectSolid(box.x, box.y, 0.f, box.width, box.height, color);
+      }
+    }
+
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_BORDER: {
+    if (!Clay3DSi__HAS_BORDERS)
+    {
+      break;
+    }
+
+    Clay_BorderElementConfig* config = renderCommand->config.borderElementConfig;
+    u32 tc = Clay3DSi__CLAY_COLOR_TO_C2D(config->top.color);
+    u32 lc = Clay3DSi__CLAY_COLOR_TO_C2D(config->left.color);
+    u32 rc = Clay3DSi__CLAY_COLOR_TO_C2D(config->right.color);
+    u32 bc = Clay3DSi__CLAY_COLOR_TO_C2D(config->bottom.color);
+    float lw = config->left.width;
+    float tw = config->top.width;
+    float rw = config->right.width;
+    float bw = config->bottom.width;
+    // Make sure that the rounding is not bigger than half of any side.
+    float max = Clay3DSi__HAS_ROUNDED_CORNERS ? Clay3DSi__MIN(box.width, box.height) / 2.f : 0.f;
+    float tlr = Clay3DSi__MIN(config->cornerRadius.topLeft, max);
+    float trr = Clay3DSi__MIN(config->cornerRadius.topRight, max);
+    float brr = Clay3DSi__MIN(config->cornerRadius.bottomRight, max);
+    float blr = Clay3DSi__MIN(config->cornerRadius.bottomLeft, max);
+
+    if (config->top.width > 0.f)
+    {
+      Clay3DSi__FillRect(state, box.x + tlr, box.y, box.width - tlr - trr, tw, tc);
+    }
+    if (config->left.width > 0.f)
+    {
+      Clay3DSi__FillRect(state, box.x, box.y + tlr, lw, box.height - tlr - blr, lc);
+    }
+    if (config->right.width > 0.f)
+    {
+      Clay3DSi__FillRect(state, box.x + box.width - rw, box.y + trr, rw, box.height - trr - brr, rc);
+    }
+    if (config->bottom.width > 0.f)
+    {
+      Clay3DSi__FillRect(state, box.x + brr, box.y + box.height - bw, box.width - blr - brr, bw, bc);
+    }
+    if (!Clay3DSi__HAS_ROUNDED_CORNERS || (tlr <= 0.f && trr <= 0.f && brr <= 0.f && blr <= 0.f) ||
+        !Clay3DSi__BeginGeometry(state, Clay3DSi__Grow(box, Clay3DSi__IsAntialiased() ? Clay3DSi__FRINGE_HALF_WIDTH : 0.f)))
+    {
+      // The arcs are not trimmed on the CPU, so they are drawn with the hardware scissor when they or their fringe
+      // cross the clip rectangle.
+      break;
+    }
+
+    // Each arc is a ring of quads, with two more quads per segment for the fringe.
+    float tf = Clay3DSi__ArcFringe(tw);
+    float bf = Clay3DSi__ArcFringe(bw);
+    u32 topArc = Clay3DSi__ARC_SEGMENTS * (tf > 0.f ? 6 : 2);
+    u32 bottomArc = Clay3DSi__ARC_SEGMENTS * (bf > 0.f ? 6 : 2);
+
+    if (tlr > 0.f && Clay3DSi__ReserveGeometry(topArc, 0))
+    {
+      Clay3DSi__DrawArc(box.x + tlr, box.y + tlr, tlr - tw / 2.f, Clay3DSi__CORNER_TOP_LEFT, tw, tf, tc);
+    }
+    if (trr > 0.f && Clay3DSi__ReserveGeometry(topArc, 0))
+    {
+      Clay3DSi__DrawArc(box.x + box.width - trr, box.y + trr, trr - tw / 2.f, Clay3DSi__CORNER_TOP_RIGHT, tw, tf, tc);
+    }
+    if (blr > 0.f && Clay3DSi__ReserveGeometry(bottomArc, 0))
+    {
+      Clay3DSi__DrawArc(box.x + blr, box.y + box.height - blr, blr - bw / 2.f, Clay3DSi__CORNER_BOTTOM_LEFT, bw, bf, bc);
+    }
+    if (brr > 0.f && Clay3DSi__ReserveGeometry(bottomArc, 0))
+    {
+      Clay3DSi__DrawArc(box.x + box.width - brr, box.y + box.height - brr, brr - bw / 2.f, Clay3DSi__CORNER_BOTTOM_RIGHT, bw, bf, bc);
+    }
+
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_TEXT: {
+    if (!Clay3DSi__HAS_TEXT || Clay3DSi__ClassifyClip(state, box) == Clay3DSi__CLIP_OUTSIDE)
+    {
+      break;
+    }
+
+    Clay_TextElementConfig* config = renderCommand->config.textElementConfig;
+    u32 color = Clay3DSi__CLAY_COLOR_TO_C2D(config->textColor);
+
+    Clay_String string = renderCommand->text;
+    u32 length = Clay3DSi__MIN(string.length, Clay3DSi__MAX_TEXT_SIZE);
+    memcpy(Clay3DSi__cvTextBuffer, string.chars, length);
+    Clay3DSi__cvTextBuffer[length] = '\0';
+
+    C2D_Font font = Clay3DSi__GetFont(config->fontId);
+    float scale = Clay3DSi__CALC_FONT_SCALE(config->fontSize);
+
+    if (Clay3DSi__ClassifyClip(state, box) == Clay3DSi__CLIP_PARTIAL)
+    {
+      Clay3DSi__DrawClippedText(state, font, Clay3DSi__cvTextBuffer, box, scale, color);
+      break;
+    }
+
+    C2D_Text text;
+    C2D_TextBuf buffer = Clay3DSi__GetStaticTextBuffer();
+    C2D_TextFontParse(&text, font, buffer, Clay3DSi__cvTextBuffer);
+    C2D_TextOptimize(&text);
+
+    // Each glyph is drawn as a quad.
+    if (Clay3DSi__BeginGeometry(state, box) && Clay3DSi__ReserveGeometry(0, text.end - text.begin))
+    {
+      C2D_DrawText(&text, C2D_WithColor, box.x, box.y, 0.f, scale, scale, color);
+    }
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
+    if (!Clay3DSi__HAS_IMAGES)
+    {
+      break;
+    }
+
+    Clay_ImageElementConfig* config = renderCommand->config.imageElementConfig;
+
+    if (Clay3DSi__HAS_IMAGE_CACHE && Clay3DSi__IsCachedImage(config->imageData))
+    {
+      Clay3DSi__DrawCachedImage(state, (Clay3DSi__CachedImage*)config->imageData, box);
+    }
+    else if (config->imageData != NULL)
+    {
+      Clay3DSi__DrawImage(state, *(C2D_Image*)config->imageData, box, NULL);
+    }
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
+    // The GPU scissor is only changed when something actually needs to be clipped by it.
+    Clay3DSi__PushClip(state, box);
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END: {
+    Clay3DSi__PopClip(state);
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_CUSTOM: {
+    if (!Clay3DSi__HAS_CUSTOM_ELEMENTS)
+    {
+      break;
+    }
+
+    Clay_CustomElementConfig* config = renderCommand->config.customElementConfig;
+    Clay3DSi__CustomHandler* handler = Clay3DSi__FindCustomHandler(config->customData);
+
+    // Custom elements without a registered handler are simply not drawn. Handlers can draw anywhere (shadows go
+    // outside of the bounding box), so the scissor is always set to the clip rectangle, instead of being classified.
+    if (handler != NULL && Clay3DSi__BeginUnboundedGeometry(state))
+    {
+      handler->draw(renderCommand, handler->userData);
+    }
+    break;
+  }
+  default: {
+    fprintf(stderr, "error: unhandled render command: %d\n", renderCommand->commandType);
+    exit(1);
+  }
+  }
+}
+
+typedef struct
+{
+  // Number of frames in which the layer was drawn from its cached texture.
+  u32 hits;
+  // Number of frames in which the layer had to be rendered again.
+  u32 misses;
+} Clay3DS_LayerStats;
+
+typedef struct
+{
+  u32 id;
+  C3D_Tex tex;
+  C3D_RenderTarget* target;
+  Tex3DS_SubTexture subtex;
+  // Hash of the commands that were rendered to the texture, relative to the layer's position.
+  u32 hash;
+  float width;
+  float height;
+  bool valid;
+  // Render call in which the layer was last drawn.
+  u32 pass;
+  Clay3DS_LayerStats stats;
+} Clay3DSi__Layer;
+
+static Clay3DSi__Layer Clay3DSi__layers[Clay3DSi__MAX_LAYERS];
+static u16 Clay3DSi__numLayers = 0;
+// Number of Clay3DS_Render calls so far, used to tell the first command of a layer from the others with its id.
+static u32 Clay3DSi__renderPass = 0;
+static inline Clay3DSi__Layer* Clay3DSi__FindLayer(u32 id)
+{
+  for (u16 i = 0; i < Clay3DSi__numLayers; ++i)
+  {
+    if (Clay3DSi__layers[i].id == id)
+    {
+      return &Clay3DSi__layers[i];
+    }
+  }
+
+  return NULL;
+}
+
+static inline void Clay3DSi__FreeLayerTexture(Clay3DSi__Layer* layer)
+{
+  if (layer->target != NULL)
+  {
+    C3D_RenderTargetDelete(layer->target);
+    C3D_TexDelete(&layer->tex);
+    layer->target = NULL;
+  }
+
+  layer->valid = false;
+}
+
+// Caches the element with the specified id, and all the elements drawn inside of it, in a texture that is only
+// rendered again when the commands of the subtree or its size change.
+//
+// The element must be drawn with a background (a rectangle configuration) or clip its children, as its first render
+// command marks where the layer begins. The layer covers the following commands as long as they are drawn inside of
+// its bounding box, or of its clip.
+//
+// @return True if successful, or false if the maximum number of layers has been reached.
+static inline bool Clay3DS_RegisterLayer(Clay_ElementId id)
+{
+  if (Clay3DSi__FindLayer(id.id) != NULL)
+  {
+    return true;
+  }
+
+  if (Clay3DSi__numLayers >= Clay3DSi__MAX_LAYERS)
+  {
+    return false;
+  }
+
+  Clay3DSi__Layer* layer = &Clay3DSi__layers[Clay3DSi__numLayers++];
+  memset(layer, 0, sizeof(*layer));
+  layer->id = id.id;
+  return true;
+}
+
+// Stops caching the element with the specified id, releasing its texture.
+static inline void Clay3DS_UnregisterLayer(Clay_ElementId id)
+{
+  Clay3DSi__Layer* layer = Clay3DSi__FindLayer(id.id);
+  if (layer != NULL)
+  {
+    Clay3DSi__FreeLayerTexture(layer);
+    *layer = Clay3DSi__layers[--Clay3DSi__numLayers];
+  }
+}
+
+// Forces the layer to be rendered again, for changes that are not visible in its render commands
+// (for example, the contents of an image or of a custom element).
+static inline void Clay3DS_InvalidateLayer(Clay_ElementId id)
+{
+  Clay3DSi__Layer* layer = Clay3DSi__FindLayer(id.id);
+  if (layer != NULL)
+  {
+    layer->valid = false;
+  }
+}
+
+// Returns the cache statistics of the layer with the specified id.
+static inline Clay3DS_LayerStats Clay3DS_GetLayerStats(Clay_ElementId id)
+{
+  Clay3DSi__Layer* layer = Clay3DSi__FindLayer(id.id);
+  return layer != NULL ? layer->stats : (Clay3DS_LayerStats){0, 0};
+}
+
+static inline u32 Clay3DSi__HashBytes(u32 hash, const void* data, u32 size)
+{
+  const u8* bytes = (const u8*)data;
+  for (u32 i = 0; i < size; ++i)
+  {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+// Hashes everything that affects the output of a render command, with its position relative to the layer.
+static inline u32 Clay3DSi__HashCommand(u32 hash, Clay_RenderCommand* renderCommand, float originX, float originY)
+{
+  Clay_BoundingBox box = renderCommand->boundingBox;
+  box.x -= originX;
+  box.y -= originY;
+  hash = Clay3DSi__HashBytes(hash, &renderCommand->commandType, sizeof(renderCommand->commandType));
+  hash = Clay3DSi__HashBytes(hash, &box, sizeof(box));
+  hash = Clay3DSi__HashBytes(hash, &Clay3DSi__antialiasing, sizeof(Clay3DSi__antialiasing));
+
+  switch (renderCommand->commandType)
+  {
+  case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
+    Clay_RectangleElementConfig* config = renderCommand->config.rectangleElementConfig;
+    hash = Clay3DSi__HashBytes(hash, &config->color, sizeof(config->color));
+    hash = Clay3DSi__HashBytes(hash, &config->cornerRadius, sizeof(config->cornerRadius));
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_BORDER: {
+    Clay_BorderElementConfig* config = renderCommand->config.borderElementConfig;
+    hash = Clay3DSi__HashBytes(hash, config, sizeof(*config));
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_TEXT: {
+    Clay_TextElementConfig* config = renderCommand->config.textElementConfig;
+    hash = Clay3DSi__HashBytes(hash, &config->textColor, sizeof(config->textColor));
+    hash = Clay3DSi__HashBytes(hash, &config->fontId, sizeof(config->fontId));
+    hash = Clay3DSi__HashBytes(hash, &config->fontSize, sizeof(config->fontSize));
+    hash = Clay3DSi__HashBytes(hash, renderCommand->text.chars, renderCommand->text.length);
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
+    Clay_ImageElementConfig* config = renderCommand->config.imageElementConfig;
+    hash = Clay3DSi__HashBytes(hash, &config->imageData, sizeof(config->imageData));
+    if (Clay3DSi__HAS_IMAGE_CACHE && Clay3DSi__IsCachedImage(config->imageData))
+    {
+      // The layer must be rendered again when the image replaces its placeholder. While the layer is visible,
+      // the image counts as drawn, so that it is not evicted just because the layer texture is used instead.
+      Clay3DSi__CachedImage* image = (Clay3DSi__CachedImage*)config->imageData;
+      bool isResident = Clay3DSi__GetImageState(image) == Clay3DSi__IMAGE_RESIDENT;
+      image->lastUsed = Clay3DSi__imageFrame;
+      hash = Clay3DSi__HashBytes(hash, &isResident, sizeof(isResident));
+    }
+    break;
+  }
+  case CLAY_RENDER_COMMAND_TYPE_CUSTOM: {
+    Clay_CustomElementConfig* config = renderCommand->config.customElementConfig;
+    hash = Clay3DSi__HashBytes(hash, &config->customData, sizeof(config->customData));
+    break;
+  }
+  default:
+    break;
+  }
+
+  return hash;
+}
+
+// Returns the index after the last command of the layer beginning at the specified index.
+static inline u32 Clay3DSi__FindLayerEnd(Clay_RenderCommandArray* renderCommands, u32 begin, u32 end)
+{
+  Clay_RenderCommand* first = Clay_RenderCommandArray_Get(renderCommands, begin);
+  Clay_BoundingBox box = first->boundingBox;
+  // An element without a background begins with its own clip, whose end belongs to the layer too.
+  s32 scissorDepth = first->commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_START ? 1 : 0;
+
+  u32 i = begin + 1;
+  for (; i < end; ++i)
+  {
+    Clay_RenderCommand* renderCommand = Clay_RenderCommandArray_Get(renderCommands, i);
+    Clay_BoundingBox child = renderCommand->boundingBox;
+
+    // Commands inside of a scroll container can be out of bounds, but still belong to the layer.
+    bool isInside = child.x >= box.x && child.y >= box.y && child.x + child.width <= box.x + box.width &&
+                    child.y + child.height <= box.y + box.height;
+    // So does the end of their clip, while the end of a clip that began before the layer closes it.
+    if (scissorDepth == 0 && (!isInside || renderCommand->commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_END))
+    {
+      break;
+    }
+
+    if (renderCommand->commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_START)
+    {
+      scissorDepth++;
+    }
+    else if (renderCommand->commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_END)
+    {
+      scissorDepth--;
+    }
+  }
+
+  return i;
+}
+
+// Makes sure that the layer has a texture big enough to hold the specified size.
+static inline bool Clay3DSi__PrepareLayerTexture(Clay3DSi__Layer* layer, float width, float height)
+{
+  u16 texWidth = 8;
+  u16 texHeight = 8;
+  while (texWidth < width)
+  {
+    texWidth <<= 1;
+  }
+  while (texHeight < height)
+  {
+    texHeight <<= 1;
+  }
+
+  if (layer->target != NULL && layer->tex.width >= texWidth && layer->tex.height >= texHeight)
+  {
+    return true;
+  }
+
+  Clay3DSi__FreeLayerTexture(layer);
+  if (!C3D_TexInitVRAM(&layer->tex, texWidth, texHeight, GPU_RGBA8))
+  {
+    return false;
+  }
+
+  layer->target = C3D_RenderTargetCreateFromTex(&layer->tex, GPU_TEXFACE_2D, 0, -1);
+  if (layer->target == NULL)
+  {
+    C3D_TexDelete(&layer->tex);
+    return false;
+  }
+
+  C3D_TexSetFilter(&layer->tex, GPU_NEAREST, GPU_NEAREST);
+  return true;
+}
+
+static inline void Clay3DSi__RenderCommands(Clay3DSi__RenderState* state, Clay_RenderCommandArray* renderCommands, u32 begin, u32 end);
+
+static inline void Clay3DSi__RenderLayer(Clay3DSi__RenderState* state, Clay3DSi__Layer* layer, Clay_RenderCommandArray* renderCommands,
+                                         u32 begin, u32 end)
+{
+  Clay_BoundingBox box = Clay_RenderCommandArray_Get(renderCommands, begin)->boundingBox;
+
+  if (box.width > Clay3DSi__MAX_LAYER_SIZE || box.height > Clay3DSi__MAX_LAYER_SIZE ||
+      !Clay3DSi__PrepareLayerTexture(layer, box.width, box.height))
+  {
+    // The layer can't be cached, so it is drawn like everything else.
+    for (u32 i = begin; i < end; ++i)
+    {
+      Clay3DSi__RenderCommand(state, Clay_RenderCommandArray_Get(renderCommands, i));
+    }
+    layer->stats.misses++;
+    return;
+  }
+
+  u32 hash = 2166136261u;
+  for (u32 i = begin; i < end; ++i)
+  {
+    hash = Clay3DSi__HashCommand(hash, Clay_RenderCommandArray_Get(renderCommands, i), box.x, box.y);
+  }
+
+  if (!layer->valid || layer->hash != hash || layer->width != box.width || layer->height != box.height)
+  {
+    C3D_Mtx view;
+    C2D_ViewSave(&view);
+
+    // The scissor is global GPU state, so it must be disabled before drawing to the layer, which has its own clip stack.
+    if (state->scissorActive)
+    {
+      Clay3DSi__SetScissor(state, false, box);
+    }
+
+    Clay_Dimensions dimensions = {layer->tex.width, layer->tex.height};
+    Clay3DSi__RenderState layerState;
+    Clay3DSi__InitRenderState(&layerState, layer->target, dimensions, box.x, box.y, true);
+
+    // The layer stores premultiplied colors. Blending its alpha like citro2d does (by the source alpha) would make
+    // translucent content more transparent than it is, and it would be made so again when the layer is drawn.
+    C2D_TargetClear(layer->target, C2D_Color32(0, 0, 0, 0));
+    C2D_SceneBegin(layer->target);
+    Clay3DSi__SetAlphaBlend(GPU_SRC_ALPHA, GPU_ONE);
+    C2D_ViewReset();
+    C2D_ViewTranslate(-box.x, -box.y);
+    Clay3DSi__RenderCommands(&layerState, renderCommands, begin, end);
+    if (layerState.scissorActive)
+    {
+      Clay3DSi__SetScissor(&layerState, false, box);
+    }
+
+    // Go back to the original target. Its scissor is enabled again when something needs it.
+    C2D_ViewRestore(&view);
+    C2D_SceneBegin(state->target);
+
+    layer->subtex = (Tex3DS_SubTexture){
+      (u16)box.width, (u16)box.height, 0.f, 1.f, box.width / layer->tex.width, 1.f - box.height / layer->tex.height,
+    };
+    layer->hash = hash;
+    layer->width = box.width;
+    layer->height = box.height;
+    layer->valid = true;
+    layer->stats.misses++;
+  }
+  else
+  {
+    layer->stats.hits++;
+  }
+
+  // Switching the blending needs the pending geometry to be drawn with the previous one, hence the flushes.
+  C2D_Image image = {&layer->tex, &layer->subtex};
+  C2D_Flush();
+  Clay3DSi__SetAlphaBlend(GPU_ONE, GPU_ONE);
+  Clay3DSi__DrawImage(state, image, box, NULL);
+  C2D_Flush();
+  Clay3DSi__SetAlphaBlend(GPU_SRC_ALPHA, GPU_SRC_ALPHA);
+}
+
+// Returns the fringe of a rounded rectangle that can be drawn in a batch, or a negative value if the command is not
+// one, if it crosses the clip rectangle, or if it begins a layer.
+static inline float Clay3DSi__GetBatchFringe(Clay3DSi__RenderState* state, Clay_RenderCommand* renderCommand)
+{
+  if (renderCommand->commandType != CLAY_RENDER_COMMAND_TYPE_RECTANGLE)
+  {
+    return -1.f;
+  }
+
+  Clay_CornerRadius radius = renderCommand->config.rectangleElementConfig->cornerRadius;
+  if (radius.topLeft <= 0.f && radius.topRight <= 0.f && radius.bottomRight <= 0.f && radius.bottomLeft <= 0.f)
+  {
+    return -1.f;
+  }
+
+  Clay3DSi__Layer* layer = Clay3DSi__HAS_LAYERS && !state->isLayer ? Clay3DSi__FindLayer(renderCommand->id) : NULL;
+  if (layer != NULL && layer->pass != Clay3DSi__renderPass)
+  {
+    return -1.f;
+  }
+
+  Clay_BoundingBox box = renderCommand->boundingBox;
+  Clay_BoundingBox bounds = Clay3DSi__Grow(box, Clay3DSi__IsAntialiased() ? Clay3DSi__FRINGE_HALF_WIDTH : 0.f);
+  if (Clay3DSi__ClassifyClip(state, bounds) != Clay3DSi__CLIP_INSIDE)
+  {
+    return -1.f;
+  }
+
+  float max = Clay3DSi__MIN(box.width, box.height) / 2.f;
+  return Clay3DSi__IsAntialiased() && max >= Clay3DSi__FRINGE_HALF_WIDTH ? Clay3DSi__FRINGE_HALF_WIDTH : 0.f;
+}
+
+// Draws the consecutive rounded rectangles starting at begin in a single draw call, with their vertices generated by
+// the batch kernel straight into linear memory. Runs that are too short, or that do not fit in the arena, are left
+// to be drawn one by one.
+//
+// @return The index of the first command that was not drawn.
+static inline u32 Clay3DSi__DrawRectRun(Clay3DSi__RenderState* state, Clay_RenderCommandArray* renderCommands, u32 begin, u32 end)
+{
+  float fringe = Clay3DSi__HAS_ROUNDED_CORNERS && !Clay3DSi__batchArenaFailed
+                   ? Clay3DSi__GetBatchFringe(state, Clay_RenderCommandArray_Get(renderCommands, begin))
+                   : -1.f;
+  if (fringe < 0.f)
+  {
+    return begin;
+  }
+
+  // The run only includes shapes with the same fringe, as they share the topology.
+  Clay3DSi__SyncBudgetFrame();
+  u32 rectVertices = Clay3DSi__RectBatchVertices(fringe);
+  u32 runEnd = begin;
+  Clay_BoundingBox bounds = Clay_RenderCommandArray_Get(renderCommands, begin)->boundingBox;
+  while (runEnd < end && Clay3DSi__batchUsed + (runEnd - begin + 1) * rectVertices <= Clay3DSi__MAX_BATCH_VERTICES)
+  {
+    Clay_RenderCommand* renderCommand = Clay_RenderCommandArray_Get(renderCommands, runEnd);
+    if (Clay3DSi__GetBatchFringe(state, renderCommand) != fringe)
+    {
+      break;
+    }
+
+    Clay_BoundingBox box = renderCommand->boundingBox;
+    float x2 = Clay3DSi__MAX(bounds.x + bounds.width, box.x + box.width);
+    float y2 = Clay3DSi__MAX(bounds.y + bounds.height, box.y + box.height);
+    bounds.x = Clay3DSi__MIN(bounds.x, box.x);
+    bounds.y = Clay3DSi__MIN(bounds.y, box.y);
+    bounds.width = x2 - bounds.x;
+    bounds.height = y2 - bounds.y;
+    runEnd++;
+  }
+
+  if (runEnd - begin < Clay3DSi__MIN_RECT_BATCH)
+  {
+    return begin;
+  }
+
+  if (Clay3DSi__batchArena == NULL)
+  {
+    Clay3DSi__batchArena = (Clay3DSi__MeshVertex*)linearAlloc(sizeof(Clay3DSi__MeshVertex) * Clay3DSi__MAX_BATCH_VERTICES * 2);
+    if (Clay3DSi__batchArena == NULL)
+    {
+      fprintf(stderr, "error: could not allocate the rounded rectangle batches, they are drawn one by one\n");
+      Clay3DSi__batchArenaFailed = true;
+      return begin;
+    }
+  }
+
+  // Every shape is inside of the clip rectangle, and so is their union, which only needs an older scissor disabled.
+  // Only the invisible triangle drawn to set up the GPU goes through the citro2d buffers.
+  Clay3DSi__BeginGeometry(state, Clay3DSi__Grow(bounds, fringe));
+  if (!Clay3DSi__ReserveGeometry(1, 0))
+  {
+    Clay3DSi__vertexStats.dropped += runEnd - begin - 1;
+    return runEnd;
+  }
+
+  Clay3DSi__MeshVertex* vertices = Clay3DSi__batchArena + Clay3DSi__batchHalf * Clay3DSi__MAX_BATCH_VERTICES + Clay3DSi__batchUsed;
+  Clay3DSi__MeshVertex* v = vertices;
+  Clay3DSi__RectBatch* batch = &Clay3DSi__rectBatch;
+  batch->fringe = fringe;
+  for (u32 i = begin; i < runEnd; i += Clay3DSi__RECT_BATCH_LANES)
+  {
+    batch->count = Clay3DSi__MIN(runEnd - i, Clay3DSi__RECT_BATCH_LANES);
+    for (u32 n = 0; n < batch->count; ++n)
+    {
+      Clay_RenderCommand* renderCommand = Clay_RenderCommandArray_Get(renderCommands, i + n);
+      Clay_RectangleElementConfig* config = renderCommand->config.rectangleElementConfig;
+      Clay_BoundingBox box = renderCommand->boundingBox;
+      // Make sure that the rounding is not bigger than half of any side.
+      float max = Clay3DSi__MIN(box.width, box.height) / 2.f;
+      batch->x[n] = box.x;
+      batch->y[n] = box.y;
+      batch->width[n] = box.width;
+      batch->height[n] = box.height;
+      batch->radius[0][n] = Clay3DSi__MIN(config->cornerRadius.topLeft, max);
+      batch->radius[1][n] = Clay3DSi__MIN(config->cornerRadius.topRight, max);
+      batch->radius[2][n] = Clay3DSi__MIN(config->cornerRadius.bottomRight, max);
+      batch->radius[3][n] = Clay3DSi__MIN(config->cornerRadius.bottomLeft, max);
+      batch->color[n] = Clay3DSi__CLAY_COLOR_TO_C2D(config->color);
+    }
+    v = Clay3DSi__BuildRectBatch(batch, v);
+  }
+
+  u32 numVertices = v - vertices;
+  GSPGPU_FlushDataCache(vertices, sizeof(Clay3DSi__MeshVertex) * numVertices);
+  Clay3DSi__DrawVertices(vertices, numVertices);
+  Clay3DSi__batchUsed += numVertices;
+  return runEnd;
+}
+
+static inline void Clay3DSi__RenderCommands(Clay3DSi__RenderState* state, Clay_RenderCommandArray* renderCommands, u32 begin, u32 end)
+{
+  for (u32 i = begin; i < end; i++)
+  {
+    Clay_RenderCommand* renderCommand = Clay_RenderCommandArray_Get(renderCommands, i);
+
+    // Only the first command of the element begins its layer. The others with the same id (like a border, after
+    // children drawn out of bounds) are drawn like everything else, or the layer would be rendered again.
+    Clay3DSi__Layer* layer = Clay3DSi__HAS_LAYERS && !state->isLayer ? Clay3DSi__FindLayer(renderCommand->id) : NULL;
+    if (layer != NULL && layer->pass != Clay3DSi__renderPass)
+    {
+      layer->pass = Clay3DSi__renderPass;
+      u32 layerEnd = Clay3DSi__FindLayerEnd(renderCommands, i, end);
+      Clay3DSi__RenderLayer(state, layer, renderCommands, i, layerEnd);
+      i = layerEnd - 1;
+      continue;
+    }
+
+    u32 runEnd = Clay3DSi__DrawRectRun(state, renderCommands, i, end);
+    if (runEnd > i)
+    {
+      i = runEnd - 1;
+      continue;
+    }
+
+    Clay3DSi__RenderCommand(state, renderCommand);
+  }
+}
+
+// Renders the specified render commands to the given render target.
+//
+// This function should be executed in a loop, after C2D_SceneBegin has been called.
+static inline void Clay3DS_Render(C3D_RenderTarget* renderTarget, Clay_Dimensions dimensions, Clay_RenderCommandArray renderCommands)
+{
+  if (Clay3DSi__HAS_IMAGE_CACHE)
+  {
+    Clay3DSi__imageRendered = true;
+  }
+  if (Clay3DSi__HAS_LAYERS)
+  {
+    Clay3DSi__renderPass++;
+  }
+
+  Clay3DSi__RenderState state;
+  Clay3DSi__InitRenderState(&state, renderTarget, dimensions, 0.f, 0.f, false);
+  Clay3DSi__RenderCommands(&state, &renderCommands, 0, renderCommands.length);
+
+  // Leave the scissor disabled, as it was when the function was called.
+  if (state.scissorActive)
+  {
+    Clay3DSi__SetScissor(&state, false, state.scissorBox);
+  }
+}
+
+typedef struct
+{
+  // Screens that are invalidated when the held keys change. Defaults to all the screens.
+  u32 keysScreens;
+  // Screens that are invalidated when the touch state changes. Defaults to the bottom screen.
+  u32 touchScreens;
+
+  u32 dirty[2];
+  u32 previousKeys;
+  touchPosition previousTouch;
+
+  Clay_ElementId scrollIds[Clay3DSi__MAX_WATCHED_SCROLLS];
+  Clay_Vector2 scrollPositions[Clay3DSi__MAX_WATCHED_SCROLLS];
+  u32 scrollScreens[Clay3DSi__MAX_WATCHED_SCROLLS];
+  u16 numScrolls;
+
+  u64 numFrames;
+  u64 numRendered[2];
+} Clay3DS_FrameDriver;
+
+static inline u32 Clay3DSi__ScreenIndex(u32 screen)
+{
+  return screen == Clay3DS_SCREEN_TOP ? 0 : 1;
+}
+
+// Initializes a frame driver, which decides on which frames each screen actually needs to be laid out and
+// rendered. While nothing changes, the last presented frame is simply kept on screen.
+static inline void Clay3DS_FrameDriverInit(Clay3DS_FrameDriver* driver)
+{
+  memset(driver, 0, sizeof(*driver));
+  driver->keysScreens = Clay3DS_SCREEN_ALL;
+  driver->touchScreens = Clay3DS_SCREEN_BOTTOM;
+
+  // The very first frame always needs to be presented.
+  driver->dirty[0] = Clay3DSi__SETTLE_FRAMES + 1;
+  driver->dirty[1] = Clay3DSi__SETTLE_FRAMES + 1;
+}
+
+// Forces the specified screens to be rendered again, for example when the application state has changed
+// or an animation is running.
+static inline void Clay3DS_FrameDriverInvalidate(Clay3DS_FrameDriver* driver, u32 screens)
+{
+  for (u32 screen = Clay3DS_SCREEN_TOP; screen <= Clay3DS_SCREEN_BOTTOM; screen <<= 1)
+  {
+    if (screens & screen)
+    {
+      driver->dirty[Clay3DSi__ScreenIndex(screen)] = Clay3DSi__SETTLE_FRAMES + 1;
+    }
+  }
+}
+
+// Watches the scroll container with the specified id, invalidating the given screens while its scroll
+// position changes (including the momentum after the pointer is released).
+//
+// @return True if successful, or false if the maximum number of watched containers has been reached.
+static inline bool Clay3DS_FrameDriverWatchScroll(Clay3DS_FrameDriver* driver, Clay_ElementId id, u32 screens)
+{
+  if (driver->numScrolls >= Clay3DSi__MAX_WATCHED_SCROLLS)
+  {
+    return false;
+  }
+
+  driver->scrollIds[driver->numScrolls] = id;
+  driver->scrollPositions[driver->numScrolls] = (Clay_Vector2){0.f, 0.f};
+  driver->scrollScreens[driver->numScrolls] = screens;
+  driver->numScrolls++;
+  return true;
+}
+
+// Updates the frame driver with the current input and scroll state.
+//
+// This function should be executed once per frame, after hidScanInput has been called. Clay forgets the scroll
+// containers that were not laid out since its previous Clay_UpdateScrollContainers call, so that function must only
+// be called in the frames that lay out every screen containing a scroll container, right before the layout. The scroll
+// positions it changes are seen by the next update, which keeps laying out the watched screens while they move.
+//
+// @return The mask of the screens that need to be laid out and rendered in this frame. If this is
+//         Clay3DS_SCREEN_NONE, the whole frame can be skipped.
+static inline u32 Clay3DS_FrameDriverUpdate(Clay3DS_FrameDriver* driver)
+{
+  u32 keys = hidKeysHeld();
+  touchPosition touch;
+  hidTouchRead(&touch);
+
+  if ((keys & ~KEY_TOUCH) != (driver->previousKeys & ~KEY_TOUCH))
+  {
+    Clay3DS_FrameDriverInvalidate(driver, driver->keysScreens);
+  }
+
+  bool isTouching = keys & KEY_TOUCH;
+  bool wasTouching = driver->previousKeys & KEY_TOUCH;
+  if (isTouching != wasTouching ||
+      (isTouching && (touch.px != driver->previousTouch.px || touch.py != driver->previousTouch.py)))
+  {
+    Clay3DS_FrameDriverInvalidate(driver, driver->touchScreens);
+  }
+
+  driver->previousKeys = keys;
+  driver->previousTouch = touch;
+
+  for (u16 i = 0; i < driver->numScrolls; ++i)
+  {
+    Clay_ScrollContainerData data = Clay_GetScrollContainerData(driver->scrollIds[i]);
+    if (!data.found || data.scrollPosition == NULL)
+    {
+      continue;
+    }
+
+    Clay_Vector2 position = *data.scrollPosition;
+    if (position.x != driver->scrollPositions[i].x || position.y != driver->scrollPositions[i].y)
+    {
+      driver->scrollPositions[i] = position;
+      Clay3DS_FrameDriverInvalidate(driver, driver->scrollScreens[i]);
+    }
+  }
+
+  u32 screens = Clay3DS_SCREEN_NONE;
+  for (u32 screen = Clay3DS_SCREEN_TOP; screen <= Clay3DS_SCREEN_BOTTOM; screen <<= 1)
+  {
+    u32 index = Clay3DSi__ScreenIndex(screen);
+    if (driver->dirty[index] > 0)
+    {
+      driver->dirty[index]--;
+      driver->numRendered[index]++;
+      screens |= screen;
+    }
+  }
+
+  driver->numFrames++;
+  return screens;
+}
+
+// Returns the fraction of the screen frames, in the [0, 1] range, that were skipped because nothing changed.
+static inline float Clay3DS_FrameDriverIdleRatio(const Clay3DS_FrameDriver* driver, u32 screens)
+{
+  u64 total = 0;
+  u64 rendered = 0;
+
+  for (u32 screen = Clay3DS_SCREEN_TOP; screen <= Clay3DS_SCREEN_BOTTOM; screen <<= 1)
+  {
+    if (screens & screen)
+    {
+      total += driver->numFrames;
+      rendered += driver->numRendered[Clay3DSi__ScreenIndex(screen)];
+    }
+  }
+
+  return total > 0 ? (float)(total - rendered) / (float)total : 0.f;
+}
 
 #endif // __CLAY3DS_H
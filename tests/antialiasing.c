@@ -0,0 +1,140 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Compares rectangles drawn with and without the anti-aliasing fringe against a 16x16 supersampled reference,
+// and reports the coverage error, summed over all the pixels, together with the number of triangles used.
+
+#include "mock.h"
+
+#include "clay3ds.h"
+#include "test.h"
+
+#define WIDTH 140
+#define HEIGHT 90
+#define SUBSAMPLES 16
+
+typedef struct
+{
+  float error;
+  u32 triangles;
+} Measurement;
+
+static bool IsInside(float px, float py, Clay_BoundingBox box, float radius)
+{
+  if (px < box.x || py < box.y || px > box.x + box.width || py > box.y + box.height)
+  {
+    return false;
+  }
+
+  float cx = fminf(fmaxf(px, box.x + radius), box.x + box.width - radius);
+  float cy = fminf(fmaxf(py, box.y + radius), box.y + box.height - radius);
+  return (px - cx) * (px - cx) + (py - cy) * (py - cy) <= radius * radius;
+}
+
+static Measurement Measure(bool antialiasing, Clay_BoundingBox box, float radius)
+{
+  static float coverage[WIDTH * HEIGHT];
+
+  Clay_RectangleElementConfig config = {{0, 0, 0, 255}, {radius, radius, radius, radius}};
+  Clay_RenderCommand command = {0};
+  command.boundingBox = box;
+  command.config.rectangleElementConfig = &config;
+  command.commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE;
+  Clay_RenderCommandArray array = {1, 1, &command};
+
+  Mock_Reset();
+  Clay3DS_SetAntialiasing(antialiasing);
+  Clay3DS_Render(NULL, (Clay_Dimensions){WIDTH, HEIGHT}, array);
+  Mock_Rasterize(coverage, WIDTH, HEIGHT);
+
+  Measurement result = {0.f, mock_counters.triangles};
+  for (int y = 0; y < HEIGHT; ++y)
+  {
+    for (int x = 0; x < WIDTH; ++x)
+    {
+      int inside = 0;
+      for (int j = 0; j < SUBSAMPLES; ++j)
+      {
+        for (int i = 0; i < SUBSAMPLES; ++i)
+        {
+          inside += IsInside(x + (i + 0.5f) / SUBSAMPLES, y + (j + 0.5f) / SUBSAMPLES, box, radius);
+        }
+      }
+      result.error += fabsf((float)inside / (SUBSAMPLES * SUBSAMPLES) - coverage[y * WIDTH + x]);
+    }
+  }
+  return result;
+}
+
+// Checks that the anti-aliased error is at most maxRatio times the aliased one.
+static void Compare(const char* name, Clay_BoundingBox box, float radius, float maxRatio)
+{
+  Measurement off = Measure(false, box, radius);
+  Measurement on = Measure(true, box, radius);
+  printf("%-20s error %6.1f -> %5.1f, triangles %3u -> %3u\n", name, off.error, on.error, off.triangles, on.triangles);
+
+  CHECK(on.error <= off.error * maxRatio + 1e-3f, "%s: error %f, expected at most %f", name, on.error, off.error * maxRatio);
+  if (off.error < 1e-3f)
+  {
+    // Edges on the pixel grid are already sharp, and get no fringe.
+    CHECK(on.triangles == off.triangles, "%s: %u triangles, expected %u", name, on.triangles, off.triangles);
+  }
+}
+
+// Draws a rectangle inside of a clip rectangle with anti-aliasing, and checks that no triangle reaches out of the
+// clip rectangle unless the hardware scissor was enabled for it.
+static void CheckClipped(const char* name, Clay_BoundingBox box, float radius, u32 expectedScissors)
+{
+  Clay_BoundingBox clip = {20.5f, 20.f, 60.f, 40.f};
+  Clay_ScrollElementConfig scroll = {true, true};
+  Clay_RectangleElementConfig config = {{0, 0, 0, 255}, {radius, radius, radius, radius}};
+  Clay_RenderCommand commands[3] = {{clip, {0}, {0}, 0, CLAY_RENDER_COMMAND_TYPE_SCISSOR_START},
+                                    {box, {0}, {0}, 0, CLAY_RENDER_COMMAND_TYPE_RECTANGLE},
+                                    {clip, {0}, {0}, 0, CLAY_RENDER_COMMAND_TYPE_SCISSOR_END}};
+  commands[0].config.scrollElementConfig = &scroll;
+  commands[1].config.rectangleElementConfig = &config;
+  commands[2].config.scrollElementConfig = &scroll;
+
+  Mock_Reset();
+  Clay3DS_SetAntialiasing(true);
+  Clay3DS_Render(NULL, (Clay_Dimensions){WIDTH, HEIGHT}, (Clay_RenderCommandArray){3, 3, commands});
+
+  // Enabling the scissor and disabling it at the end are two changes.
+  CHECK(mock_counters.scissors == expectedScissors * 2, "%s: the scissor was set %u times", name, mock_counters.scissors);
+  if (expectedScissors > 0)
+  {
+    return;
+  }
+
+  for (u32 i = 0; i < mock_counters.triangles; ++i)
+  {
+    const Mock_Triangle* t = &mock_triangles[i];
+    for (u32 j = 0; j < 3; ++j)
+    {
+      bool isInside = t->x[j] >= clip.x - 1e-4f && t->y[j] >= clip.y - 1e-4f && t->x[j] <= clip.x + clip.width + 1e-4f &&
+                      t->y[j] <= clip.y + clip.height + 1e-4f;
+      CHECK(isInside, "%s: vertex at %g,%g is out of the clip rectangle", name, t->x[j], t->y[j]);
+    }
+  }
+}
+
+int main(void)
+{
+  // Most of the error left on rounded rectangles comes from approximating the corners with four segments, which the
+  // fringe does not change, so only the fractional edges are expected to improve much.
+  Compare("rounded, fractional", (Clay_BoundingBox){10.3f, 20.6f, 100.2f, 50.5f}, 16.f, 0.5f);
+  Compare("rounded, aligned", (Clay_BoundingBox){10.f, 20.f, 100.f, 50.f}, 16.f, 1.f);
+  Compare("square, fractional", (Clay_BoundingBox){10.3f, 20.6f, 100.2f, 50.5f}, 0.f, 0.1f);
+  Compare("square, aligned", (Clay_BoundingBox){10.f, 20.f, 100.f, 50.f}, 0.f, 1.f);
+
+  // Edges cut by the clip rectangle are left sharp, and are trimmed without the scissor. The fringe of shapes that
+  // are not trimmed enables the scissor when it crosses the clip rectangle, even if the shape itself does not.
+  CheckClipped("square, cut", (Clay_BoundingBox){10.3f, 25.5f, 40.2f, 20.5f}, 0.f, 0);
+  CheckClipped("square, near edge", (Clay_BoundingBox){20.8f, 25.5f, 40.2f, 20.5f}, 0.f, 1);
+  CheckClipped("rounded, near edge", (Clay_BoundingBox){20.8f, 25.5f, 40.2f, 20.5f}, 6.f, 1);
+  return TEST_RESULT();
+}
@@ -0,0 +1,179 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Checks that nested clip rectangles are intersected, that images and text crossing them are culled and trimmed on
+// the CPU, and that the hardware scissor is only changed for the geometry that needs it.
+
+#include <math.h>
+
+#include "mock.h"
+
+#include "clay3ds.h"
+#include "test.h"
+
+#define WIDTH 400
+#define HEIGHT 240
+#define MAX_CAPTURES 4
+#define EPSILON 1e-4f
+
+static int captureKey;
+static Clay_CustomElementConfig captureConfig = {&captureKey};
+static Clay_ScrollElementConfig scroll = {true, true};
+static Clay_TextElementConfig textConfig = {{255, 255, 255, 255}, Clay3DS_FONT_SYSTEM, 30, 0, 30, 0};
+
+static u32 numCaptures = 0;
+static u32 capturedScissors[MAX_CAPTURES];
+static GPU_SCISSORMODE capturedModes[MAX_CAPTURES];
+static u32 capturedScissor[MAX_CAPTURES][4];
+
+// Custom draw function that stores the scissor that it is drawn with, and how many times it was set until then.
+static void CaptureScissor(Clay_RenderCommand* command, void* userData)
+{
+  (void)command;
+  (void)userData;
+  if (numCaptures < MAX_CAPTURES)
+  {
+    capturedScissors[numCaptures] = mock_counters.scissors;
+    capturedModes[numCaptures] = mock_counters.scissorMode;
+    memcpy(capturedScissor[numCaptures], mock_counters.scissor, sizeof(capturedScissor[numCaptures]));
+  }
+  numCaptures++;
+}
+
+static bool Near(float a, float b)
+{
+  return fabsf(a - b) < EPSILON;
+}
+
+// Checks that a capture used the scissor of the specified clip rectangle, in the rotated screen coordinates.
+static void CheckScissor(u32 capture, Clay_BoundingBox clip, u32 scissors)
+{
+  // clang-format off
+  u32 expected[4] = {
+    HEIGHT - clip.height - clip.y,
+    WIDTH - clip.width - clip.x,
+    clip.height + clip.y,
+    WIDTH - clip.x,
+  };
+  // clang-format on
+
+  CHECK(capture < numCaptures && capturedModes[capture] == GPU_SCISSOR_NORMAL, "capture %u is not scissored", capture);
+  CHECK(memcmp(capturedScissor[capture], expected, sizeof(expected)) == 0, "capture %u scissor is %u,%u,%u,%u instead of %u,%u,%u,%u",
+        capture, capturedScissor[capture][0], capturedScissor[capture][1], capturedScissor[capture][2], capturedScissor[capture][3],
+        expected[0], expected[1], expected[2], expected[3]);
+  CHECK(capturedScissors[capture] == scissors, "the scissor was set %u times before capture %u, expected %u",
+        capturedScissors[capture], capture, scissors);
+}
+
+static Clay_RenderCommand MakeCommand(Clay_RenderCommandType type, Clay_BoundingBox box)
+{
+  Clay_RenderCommand command = {0};
+  command.boundingBox = box;
+  command.commandType = type;
+  switch (type)
+  {
+  case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START:
+  case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END:
+    command.config.scrollElementConfig = &scroll;
+    break;
+  case CLAY_RENDER_COMMAND_TYPE_CUSTOM:
+    command.config.customElementConfig = &captureConfig;
+    break;
+  default:
+    break;
+  }
+  return command;
+}
+
+static Clay_RenderCommand MakeText(const char* string, Clay_BoundingBox box)
+{
+  Clay_RenderCommand command = MakeCommand(CLAY_RENDER_COMMAND_TYPE_TEXT, box);
+  command.config.textElementConfig = &textConfig;
+  command.text = (Clay_String){(int32_t)strlen(string), string};
+  return command;
+}
+
+int main(void)
+{
+  Clay3DS_SetAntialiasing(false);
+  CHECK(Clay3DS_RegisterCustomHandler(&captureKey, CaptureScissor, NULL), "could not register the scissor handler");
+
+  C3D_Tex texture = {0};
+  texture.width = 64;
+  texture.height = 32;
+  Tex3DS_SubTexture subtex = {64, 32, 0.f, 1.f, 1.f, 0.f};
+  C2D_Image image = {&texture, &subtex};
+  Clay_ImageElementConfig imageConfig = {&image, {64, 32}};
+
+  Clay_BoundingBox outer = {10.f, 10.f, 200.f, 100.f};
+  Clay_BoundingBox inner = {50.f, 40.f, 300.f, 150.f};
+  Clay_BoundingBox nested = {50.f, 40.f, 160.f, 70.f};
+
+  Clay_RenderCommand commands[] = {
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_SCISSOR_START, outer),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_SCISSOR_START, inner),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_CUSTOM, (Clay_BoundingBox){60.f, 50.f, 10.f, 10.f}),
+    // Inside of the inner clip rectangle, but outside of the outer one.
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_IMAGE, (Clay_BoundingBox){250.f, 60.f, 60.f, 30.f}),
+    // Crossing the right edge of the nested clip rectangle at half of its width.
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_IMAGE, (Clay_BoundingBox){180.f, 50.f, 60.f, 20.f}),
+    // Crossing the right edge with its third glyph, which spans from 200 to 220.
+    MakeText("ABCDEFGH", (Clay_BoundingBox){150.f, 60.f, 8.f * MOCK_GLYPH_ADVANCE, 30.f}),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_SCISSOR_END, inner),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_CUSTOM, (Clay_BoundingBox){20.f, 20.f, 10.f, 10.f}),
+    MakeText("Hi", (Clay_BoundingBox){20.f, 20.f, 2.f * MOCK_GLYPH_ADVANCE, 30.f}),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_SCISSOR_END, outer),
+  };
+  commands[3].config.imageElementConfig = &imageConfig;
+  commands[4].config.imageElementConfig = &imageConfig;
+
+  Mock_Reset();
+  u32 count = sizeof(commands) / sizeof(commands[0]);
+  Clay3DS_Render(NULL, (Clay_Dimensions){WIDTH, HEIGHT}, (Clay_RenderCommandArray){count, count, commands});
+
+  // Custom elements get the intersection of the clip rectangles as scissor. The trimmed images and glyphs in between
+  // do not change it.
+  CHECK(numCaptures == 2, "%u custom elements drawn", numCaptures);
+  CheckScissor(0, nested, 1);
+  CheckScissor(1, outer, 2);
+  CHECK(mock_counters.scissors == 3 && mock_counters.scissorMode == GPU_SCISSOR_DISABLE, "the scissor was left enabled");
+
+  // The image outside of the nested clip rectangle is culled, and the crossing one is trimmed along with its
+  // texture coordinates. So are the glyphs of the crossing text, which are drawn one by one.
+  CHECK(mock_counters.images == 4, "%u images drawn", mock_counters.images);
+  CHECK(mock_counters.texts == 1, "%u strings drawn as a whole", mock_counters.texts);
+
+  const Mock_Image* trimmed = &mock_images[0];
+  CHECK(trimmed->tex == &texture, "the first image drawn is not the crossing one");
+  CHECK(Near(trimmed->rect[0], 180.f) && Near(trimmed->rect[1], 50.f) && Near(trimmed->rect[2], 30.f) &&
+          Near(trimmed->rect[3], 20.f),
+        "the image was drawn at %g,%g %gx%g", trimmed->rect[0], trimmed->rect[1], trimmed->rect[2], trimmed->rect[3]);
+  CHECK(Near(trimmed->subtex.left, 0.f) && Near(trimmed->subtex.right, 0.5f) && Near(trimmed->subtex.top, 1.f) &&
+          Near(trimmed->subtex.bottom, 0.f),
+        "the image samples u %g-%g, v %g-%g", trimmed->subtex.left, trimmed->subtex.right, trimmed->subtex.top,
+        trimmed->subtex.bottom);
+
+  for (u32 i = 0; i < 3 && i + 1 < mock_counters.images; ++i)
+  {
+    const Mock_Image* glyph = &mock_images[i + 1];
+    fontGlyphPos_s position;
+    C2D_FontCalcGlyphPos(NULL, &position, 'A' + i, GLYPH_POS_CALC_VTXCOORD, 1.f, 1.f);
+
+    float x = 150.f + i * MOCK_GLYPH_ADVANCE + MOCK_GLYPH_OFFSET;
+    float width = i < 2 ? MOCK_GLYPH_WIDTH : nested.x + nested.width - x;
+    float right = position.texcoord.left + (position.texcoord.right - position.texcoord.left) * width / MOCK_GLYPH_WIDTH;
+    CHECK(Near(glyph->rect[0], x) && Near(glyph->rect[1], 60.f) && Near(glyph->rect[2], width) &&
+            Near(glyph->rect[3], MOCK_GLYPH_HEIGHT),
+          "glyph %u was drawn at %g,%g %gx%g", i, glyph->rect[0], glyph->rect[1], glyph->rect[2], glyph->rect[3]);
+    CHECK(Near(glyph->subtex.left, position.texcoord.left) && Near(glyph->subtex.right, right) &&
+            Near(glyph->subtex.top, position.texcoord.top) && Near(glyph->subtex.bottom, position.texcoord.bottom),
+          "glyph %u samples u %g-%g, v %g-%g", i, glyph->subtex.left, glyph->subtex.right, glyph->subtex.top,
+          glyph->subtex.bottom);
+  }
+
+  return TEST_RESULT();
+}
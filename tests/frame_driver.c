@@ -0,0 +1,115 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Checks that the frame driver skips the idle frames, and that input and watched scroll containers keep the
+// screens they are configured for live until they settle.
+
+#include "mock.h"
+
+#include "clay3ds.h"
+#include "test.h"
+
+#define IDLE_FRAMES 10
+#define SCROLL_FRAMES 5
+
+static u32 numFrames = 0;
+static u32 numRendered[2] = {0, 0};
+
+// Runs one frame update, counting the frames that each screen is rendered in.
+//
+// @return The screens that need to be rendered.
+static u32 Update(Clay3DS_FrameDriver* driver)
+{
+  u32 screens = Clay3DS_FrameDriverUpdate(driver);
+  numFrames++;
+  numRendered[0] += (screens & Clay3DS_SCREEN_TOP) != 0;
+  numRendered[1] += (screens & Clay3DS_SCREEN_BOTTOM) != 0;
+  return screens;
+}
+
+// Checks that the next frames render the specified screens for as long as they take to settle, and are then idle.
+static void CheckSettles(Clay3DS_FrameDriver* driver, u32 screens, const char* cause)
+{
+  for (u32 i = 0; i < Clay3DSi__SETTLE_FRAMES + 1; ++i)
+  {
+    u32 rendered = Update(driver);
+    CHECK(rendered == screens, "%s: frame %u rendered the screens 0x%x instead of 0x%x", cause, i, rendered, screens);
+  }
+
+  for (u32 i = 0; i < IDLE_FRAMES; ++i)
+  {
+    u32 rendered = Update(driver);
+    CHECK(rendered == Clay3DS_SCREEN_NONE, "%s: idle frame %u rendered the screens 0x%x", cause, i, rendered);
+  }
+}
+
+int main(void)
+{
+  Clay3DS_FrameDriver driver;
+  Clay3DS_FrameDriverInit(&driver);
+
+  // The first frame is always presented.
+  CheckSettles(&driver, Clay3DS_SCREEN_ALL, "first frame");
+
+  // Pressing and releasing a key invalidates the key screens, while holding it does not.
+  mock_keys = KEY_A;
+  CheckSettles(&driver, Clay3DS_SCREEN_ALL, "key press");
+  mock_keys = 0;
+  CheckSettles(&driver, Clay3DS_SCREEN_ALL, "key release");
+
+  driver.keysScreens = Clay3DS_SCREEN_TOP;
+  mock_keys = KEY_A;
+  CheckSettles(&driver, Clay3DS_SCREEN_TOP, "configured key press");
+  mock_keys = 0;
+  CheckSettles(&driver, Clay3DS_SCREEN_TOP, "configured key release");
+
+  // Touching only invalidates the touch screens, and so does dragging, while a still touch does not.
+  mock_keys = KEY_TOUCH;
+  mock_touch = (touchPosition){100, 100};
+  CheckSettles(&driver, Clay3DS_SCREEN_BOTTOM, "touch");
+  mock_touch = (touchPosition){120, 90};
+  CheckSettles(&driver, Clay3DS_SCREEN_BOTTOM, "drag");
+  mock_keys = 0;
+  CheckSettles(&driver, Clay3DS_SCREEN_BOTTOM, "release");
+
+  // Moving the touch position while not touching is ignored.
+  mock_touch = (touchPosition){0, 0};
+  CheckSettles(&driver, Clay3DS_SCREEN_NONE, "stale touch");
+
+  // A watched scroll container keeps its screen live while it moves, and settles once it stops.
+  Clay_ElementId id = {1, 0, 1, {0}};
+  CHECK(Clay3DS_FrameDriverWatchScroll(&driver, id, Clay3DS_SCREEN_TOP), "could not watch the scroll container");
+  Clay_Vector2 position = {0.f, 0.f};
+  mock_scrollPosition = &position;
+  CheckSettles(&driver, Clay3DS_SCREEN_NONE, "still scroll");
+
+  for (u32 i = 0; i < SCROLL_FRAMES; ++i)
+  {
+    position.y -= 4.f;
+    u32 rendered = Update(&driver);
+    CHECK(rendered == Clay3DS_SCREEN_TOP, "scroll frame %u rendered the screens 0x%x", i, rendered);
+  }
+  position.y -= 4.f;
+  CheckSettles(&driver, Clay3DS_SCREEN_TOP, "last scroll frame");
+
+  // Containers that are not laid out are ignored.
+  mock_scrollPosition = NULL;
+  CheckSettles(&driver, Clay3DS_SCREEN_NONE, "missing scroll");
+
+  // The idle ratio matches the frames that were actually skipped.
+  float top = (float)(numFrames - numRendered[0]) / numFrames;
+  float bottom = (float)(numFrames - numRendered[1]) / numFrames;
+  float all = (float)(2 * numFrames - numRendered[0] - numRendered[1]) / (2 * numFrames);
+  CHECK(Clay3DS_FrameDriverIdleRatio(&driver, Clay3DS_SCREEN_TOP) == top, "top idle ratio is not %.3f", top);
+  CHECK(Clay3DS_FrameDriverIdleRatio(&driver, Clay3DS_SCREEN_BOTTOM) == bottom, "bottom idle ratio is not %.3f", bottom);
+  CHECK(Clay3DS_FrameDriverIdleRatio(&driver, Clay3DS_SCREEN_ALL) == all, "idle ratio is not %.3f", all);
+  CHECK(Clay3DS_FrameDriverIdleRatio(&driver, Clay3DS_SCREEN_NONE) == 0.f, "idle ratio of no screens is not zero");
+  CHECK(top > 0.5f && bottom > 0.5f, "most frames should have been skipped");
+
+  printf("frame driver: %u frames, idle ratio %.2f top, %.2f bottom\n", numFrames, top, bottom);
+  return TEST_RESULT();
+}
@@ -0,0 +1,146 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Loads images from files through the worker thread, and checks the placeholder, the failures, and the eviction
+// of the least recently drawn images when over budget.
+
+#include <time.h>
+
+#include "mock.h"
+
+#include "clay3ds.h"
+#include "test.h"
+
+#define IMAGE_SIZE 64
+#define IMAGE_BYTES (IMAGE_SIZE * IMAGE_SIZE * 4)
+#define MAX_FRAMES 1000
+
+// Runs one frame that draws the specified image handles, the second of which can be NULL.
+//
+// @return The result of the cache update.
+static bool DrawFrame(void* handle, void* other)
+{
+  Clay_ImageElementConfig configs[2] = {{handle, {IMAGE_SIZE, IMAGE_SIZE}}, {other, {IMAGE_SIZE, IMAGE_SIZE}}};
+  Clay_RenderCommand commands[2];
+  for (u32 i = 0; i < 2; ++i)
+  {
+    commands[i] = (Clay_RenderCommand){0};
+    commands[i].boundingBox = (Clay_BoundingBox){IMAGE_SIZE * i, 0.f, IMAGE_SIZE, IMAGE_SIZE};
+    commands[i].config.imageElementConfig = &configs[i];
+    commands[i].commandType = CLAY_RENDER_COMMAND_TYPE_IMAGE;
+  }
+  u32 count = other != NULL ? 2 : 1;
+  Clay_RenderCommandArray array = {count, count, commands};
+
+  bool isChanged = Clay3DS_ImageCacheUpdate();
+  Clay3DS_Render(NULL, (Clay_Dimensions){400, 240}, array);
+  return isChanged;
+}
+
+static void Sleep(void)
+{
+  nanosleep(&(struct timespec){0, 1000000}, NULL);
+}
+
+// Draws the image until it stops loading, giving the worker thread a millisecond per frame. The loading must be
+// reported by an update, which is the next one when the worker thread fails after the update of the last frame.
+//
+// @return The final state of the image.
+static u32 DrawUntilLoaded(void* handle)
+{
+  u32 state = Clay3DSi__IMAGE_UNLOADED;
+  bool isChanged = false;
+  for (u32 i = 0; i < MAX_FRAMES; ++i)
+  {
+    isChanged |= DrawFrame(handle, NULL);
+    state = Clay3DSi__GetImageState((Clay3DSi__CachedImage*)handle);
+    if (state == Clay3DSi__IMAGE_RESIDENT || state == Clay3DSi__IMAGE_FAILED)
+    {
+      isChanged = isChanged || Clay3DS_ImageCacheUpdate();
+      CHECK(isChanged, "the update did not report the end of the loading");
+      break;
+    }
+
+    Sleep();
+  }
+  return state;
+}
+
+int main(void)
+{
+  const char* first = "image_cache_first.t3x";
+  const char* second = "image_cache_second.t3x";
+  const char* invalid = "image_cache_invalid.t3x";
+
+  FILE* file = fopen(invalid, "wb");
+  bool isWritten = Mock_WriteTexture(first, IMAGE_SIZE, IMAGE_SIZE) && Mock_WriteTexture(second, IMAGE_SIZE, IMAGE_SIZE) &&
+                   file != NULL && fputs("not a texture", file) >= 0;
+  if (file != NULL)
+  {
+    fclose(file);
+  }
+  CHECK(isWritten, "could not write the test files");
+
+  // The budget fits a single image.
+  CHECK(Clay3DS_ImageCacheInit(IMAGE_BYTES + IMAGE_BYTES / 2), "could not start the worker thread");
+
+  void* firstImage = Clay3DS_CachedImage(first);
+  CHECK(firstImage != NULL && Clay3DS_CachedImage(first) == firstImage, "paths must map to a single handle");
+
+  // The placeholder is drawn instead of the image until it is resident.
+  Mock_Reset();
+  DrawFrame(firstImage, NULL);
+  CHECK(mock_counters.images == 0 && mock_counters.rects == 1, "the placeholder was not drawn");
+
+  CHECK(DrawUntilLoaded(firstImage) == Clay3DSi__IMAGE_RESIDENT, "%s was not loaded", first);
+  Mock_Reset();
+  DrawFrame(firstImage, NULL);
+  CHECK(mock_counters.images == 1, "the resident image was not drawn");
+
+  Clay3DS_ImageCacheStats stats = Clay3DS_GetImageCacheStats();
+  CHECK(stats.loads == 1 && stats.residentBytes == IMAGE_BYTES, "%u loads, %u bytes resident", stats.loads, stats.residentBytes);
+  CHECK(stats.hits == 2 && stats.misses >= 1, "%u hits, %u misses", stats.hits, stats.misses);
+
+  CHECK(DrawUntilLoaded(Clay3DS_CachedImage(invalid)) == Clay3DSi__IMAGE_FAILED, "%s was not rejected", invalid);
+  CHECK(DrawUntilLoaded(Clay3DS_CachedImage("image_cache_missing.t3x")) == Clay3DSi__IMAGE_FAILED, "missing file not rejected");
+
+  // The second image is requested, and then loaded while the frames are skipped, like the frame driver does when
+  // nothing changes. The skipped frames do not age the first image, which is only evicted two drawn frames later.
+  void* secondImage = Clay3DS_CachedImage(second);
+  DrawFrame(firstImage, secondImage);
+  bool isChanged = false;
+  for (u32 i = 0; i < MAX_FRAMES && !isChanged; ++i)
+  {
+    Sleep();
+    isChanged = Clay3DS_ImageCacheUpdate();
+  }
+  CHECK(isChanged, "%s was not loaded while idle", second);
+  CHECK(Clay3DSi__GetImageState((Clay3DSi__CachedImage*)firstImage) == Clay3DSi__IMAGE_RESIDENT, "%s evicted while idle", first);
+  DrawFrame(secondImage, NULL);
+  DrawFrame(secondImage, NULL);
+
+  stats = Clay3DS_GetImageCacheStats();
+  CHECK(stats.evictions == 1, "%u evictions", stats.evictions);
+  CHECK(stats.residentBytes == IMAGE_BYTES, "%u bytes resident", stats.residentBytes);
+  CHECK(Clay3DSi__GetImageState((Clay3DSi__CachedImage*)firstImage) == Clay3DSi__IMAGE_UNLOADED, "%s was not evicted", first);
+  CHECK(Clay3DSi__GetImageState((Clay3DSi__CachedImage*)secondImage) == Clay3DSi__IMAGE_RESIDENT, "%s was evicted", second);
+
+  // An evicted image is loaded again when it is drawn.
+  CHECK(DrawUntilLoaded(firstImage) == Clay3DSi__IMAGE_RESIDENT, "%s was not loaded again", first);
+
+  stats = Clay3DS_GetImageCacheStats();
+  printf("image cache: %u loads, average latency %.1f ms, hit ratio %.2f (%u hits, %u misses), %u evictions\n", stats.loads,
+         stats.averageLatency, (float)stats.hits / (stats.hits + stats.misses), stats.hits, stats.misses, stats.evictions);
+
+  Clay3DS_ImageCacheExit();
+  CHECK(Clay3DS_GetImageCacheStats().residentBytes == 0, "the images were not released");
+
+  remove(first);
+  remove(second);
+  remove(invalid);
+  return TEST_RESULT();
+}
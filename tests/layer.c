@@ -0,0 +1,138 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Checks which commands cached layers cover, that they are only rendered again when their commands change, and
+// that clipping inside of them is applied in the texture coordinates.
+
+#include "mock.h"
+
+#include "clay3ds.h"
+#include "test.h"
+
+#define CLIPPED_ID 1
+#define SCROLL_ID 2
+#define OVERFLOW_ID 3
+
+static Clay_RectangleElementConfig background = {{255, 255, 255, 255}, {0.f, 0.f, 0.f, 0.f}};
+static Clay_ScrollElementConfig scroll = {false, true};
+static Clay_BorderElementConfig border = {
+  {1, {0, 0, 0, 255}}, {1, {0, 0, 0, 255}}, {1, {0, 0, 0, 255}}, {1, {0, 0, 0, 255}}, {0, {0, 0, 0, 0}}, {0.f, 0.f, 0.f, 0.f},
+};
+
+static int captureKey;
+static Clay_CustomElementConfig captureConfig = {&captureKey};
+static GPU_SCISSORMODE capturedMode;
+static u32 capturedScissor[4];
+
+// Custom draw function that stores the scissor that it is drawn with.
+static void CaptureScissor(Clay_RenderCommand* command, void* userData)
+{
+  (void)command;
+  (void)userData;
+  capturedMode = mock_counters.scissorMode;
+  memcpy(capturedScissor, mock_counters.scissor, sizeof(capturedScissor));
+}
+
+static Clay_RenderCommand MakeCommand(Clay_RenderCommandType type, u32 id, Clay_BoundingBox box)
+{
+  Clay_RenderCommand command = {0};
+  command.boundingBox = box;
+  command.id = id;
+  command.commandType = type;
+  switch (type)
+  {
+  case CLAY_RENDER_COMMAND_TYPE_RECTANGLE:
+    command.config.rectangleElementConfig = &background;
+    break;
+  case CLAY_RENDER_COMMAND_TYPE_BORDER:
+    command.config.borderElementConfig = &border;
+    break;
+  case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START:
+  case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END:
+    command.config.scrollElementConfig = &scroll;
+    break;
+  case CLAY_RENDER_COMMAND_TYPE_CUSTOM:
+    command.config.customElementConfig = &captureConfig;
+    break;
+  default:
+    break;
+  }
+  return command;
+}
+
+static void Render(Clay_RenderCommand* commands, u32 count)
+{
+  Mock_Reset();
+  Clay3DS_Render(NULL, (Clay_Dimensions){400, 240}, (Clay_RenderCommandArray){count, count, commands});
+}
+
+static Clay_ElementId MakeId(u32 id)
+{
+  return (Clay_ElementId){id, 0, id, {0}};
+}
+
+int main(void)
+{
+  Clay3DS_SetAntialiasing(false);
+  CHECK(Clay3DS_RegisterCustomHandler(&captureKey, CaptureScissor, NULL), "could not register the scissor handler");
+
+  // A clip inside of a layer is applied to the layer texture, whose rows go from the bottom up.
+  Clay_BoundingBox box = {20.f, 30.f, 100.f, 80.f};
+  Clay_BoundingBox clip = {30.f, 40.f, 50.f, 30.f};
+  Clay_RenderCommand clipped[] = {
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_RECTANGLE, CLIPPED_ID, box),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_SCISSOR_START, CLIPPED_ID + 10, clip),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_CUSTOM, CLIPPED_ID + 20, (Clay_BoundingBox){30.f, 40.f, 20.f, 20.f}),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_SCISSOR_END, CLIPPED_ID + 10, clip),
+  };
+  CHECK(Clay3DS_RegisterLayer(MakeId(CLIPPED_ID)), "could not register the layer");
+  Render(clipped, 4);
+
+  float height = Clay3DSi__FindLayer(CLIPPED_ID)->tex.height;
+  u32 expected[4] = {10, height - 10 - 30, 10 + 50, height - 10};
+  CHECK(capturedMode == GPU_SCISSOR_NORMAL, "the clip inside of the layer did not enable the scissor");
+  CHECK(memcmp(capturedScissor, expected, sizeof(expected)) == 0, "the layer scissor is %u,%u,%u,%u instead of %u,%u,%u,%u",
+        capturedScissor[0], capturedScissor[1], capturedScissor[2], capturedScissor[3], expected[0], expected[1], expected[2],
+        expected[3]);
+  CHECK(mock_counters.scissorMode == GPU_SCISSOR_DISABLE, "the scissor was left enabled");
+
+  // An element without a background begins with its clip, and its scrolled content belongs to the layer even when it
+  // is out of bounds.
+  Clay_RenderCommand scrolled[] = {
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_SCISSOR_START, SCROLL_ID, box),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_RECTANGLE, SCROLL_ID + 10, (Clay_BoundingBox){20.f, 40.f, 100.f, 40.f}),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_RECTANGLE, SCROLL_ID + 20, (Clay_BoundingBox){20.f, 90.f, 100.f, 40.f}),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_SCISSOR_END, SCROLL_ID, box),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_RECTANGLE, SCROLL_ID + 30, (Clay_BoundingBox){200.f, 30.f, 40.f, 40.f}),
+  };
+  CHECK(Clay3DS_RegisterLayer(MakeId(SCROLL_ID)), "could not register the layer");
+  Render(scrolled, 5);
+  Render(scrolled, 5);
+  Clay3DS_LayerStats stats = Clay3DS_GetLayerStats(MakeId(SCROLL_ID));
+  CHECK(stats.hits == 1 && stats.misses == 1, "scroll layer: %u hits, %u misses", stats.hits, stats.misses);
+  CHECK(mock_counters.images == 1 && mock_counters.rects == 1, "scroll layer: %u images and %u rectangles drawn on screen",
+        mock_counters.images, mock_counters.rects);
+
+  // When a child overflows the element, the layer ends there, and the border of the element that follows is drawn
+  // normally instead of beginning the layer again.
+  Clay_RenderCommand overflowing[] = {
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_RECTANGLE, OVERFLOW_ID, box),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_RECTANGLE, OVERFLOW_ID + 10, (Clay_BoundingBox){30.f, 40.f, 20.f, 20.f}),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_RECTANGLE, OVERFLOW_ID + 20, (Clay_BoundingBox){100.f, 100.f, 60.f, 60.f}),
+    MakeCommand(CLAY_RENDER_COMMAND_TYPE_BORDER, OVERFLOW_ID, box),
+  };
+  CHECK(Clay3DS_RegisterLayer(MakeId(OVERFLOW_ID)), "could not register the layer");
+  for (u32 i = 0; i < 3; ++i)
+  {
+    Render(overflowing, 4);
+  }
+  stats = Clay3DS_GetLayerStats(MakeId(OVERFLOW_ID));
+  CHECK(stats.hits == 2 && stats.misses == 1, "overflowing layer: %u hits, %u misses", stats.hits, stats.misses);
+  CHECK(mock_counters.images == 1, "overflowing layer: %u images drawn", mock_counters.images);
+
+  return TEST_RESULT();
+}
@@ -0,0 +1,93 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Checks that meshes are drawn from their own vertex buffer in a single call, and that drawing one inside of a
+// cached layer keeps the blending of the layer.
+
+#include "mock.h"
+
+#include "clay3ds.h"
+#include "test.h"
+
+#define LAYER_ID 42
+
+static GPU_BLENDFACTOR capturedBlend[2];
+
+// Custom draw function that stores the blending that the following draws would use.
+static void CaptureBlend(Clay_RenderCommand* command, void* userData)
+{
+  (void)command;
+  (void)userData;
+  capturedBlend[0] = mock_counters.blend[0];
+  capturedBlend[1] = mock_counters.blend[1];
+}
+
+static Clay_RenderCommand MakeCustom(Clay_CustomElementConfig* config, Clay_BoundingBox box)
+{
+  Clay_RenderCommand command = {0};
+  command.boundingBox = box;
+  command.config.customElementConfig = config;
+  command.commandType = CLAY_RENDER_COMMAND_TYPE_CUSTOM;
+  return command;
+}
+
+int main(void)
+{
+  Clay3DS_Mesh* mesh = Clay3DS_MeshCreate(10.f, 10.f, 2);
+  CHECK(mesh != NULL, "could not create the mesh");
+  if (mesh == NULL)
+  {
+    return TEST_RESULT();
+  }
+
+  u32 color = C2D_Color32(255, 0, 0, 255);
+  CHECK(Clay3DS_MeshAddTriangle(mesh, 0.f, 0.f, color, 10.f, 0.f, color, 0.f, 10.f, color), "could not add a triangle");
+  CHECK(Clay3DS_MeshAddTriangle(mesh, 10.f, 0.f, color, 10.f, 10.f, color, 0.f, 10.f, color), "could not add a triangle");
+  CHECK(!Clay3DS_MeshAddTriangle(mesh, 0.f, 0.f, color, 1.f, 0.f, color, 0.f, 1.f, color), "a full mesh accepted a triangle");
+
+  // The vertices are drawn straight from the mesh, and citro2d only gets an empty triangle to set up the transform.
+  Mock_Reset();
+  Clay3DS_DrawMesh(mesh, (Clay_BoundingBox){20.f, 20.f, 40.f, 30.f});
+  CHECK(mock_counters.arrayVertices == 6 && mock_counters.buffer == mesh->vertices, "%u vertices drawn from %p instead of %p",
+        mock_counters.arrayVertices, mock_counters.buffer, (void*)mesh->vertices);
+  u32 citro2dTriangles = mock_counters.triangles - mock_counters.arrayVertices / 3;
+  CHECK(citro2dTriangles == 1 && mock_counters.flushes == 1 && mock_counters.prepares == 1,
+        "%u citro2d triangles, %u flushes, %u prepares", citro2dTriangles, mock_counters.flushes, mock_counters.prepares);
+  CHECK(!mesh->dirty, "the vertices were not flushed from the data cache");
+
+  // Inside of a layer, the premultiplied blending of the layer is restored once citro2d takes the GPU back.
+  static int meshKey;
+  static int captureKey;
+  Clay_CustomElementConfig meshConfig = {&meshKey};
+  Clay_CustomElementConfig captureConfig = {&captureKey};
+  Clay_RectangleElementConfig background = {{255, 255, 255, 255}, {0.f, 0.f, 0.f, 0.f}};
+  CHECK(Clay3DS_RegisterCustomHandler(&meshKey, Clay3DS_MeshHandler, mesh), "could not register the mesh handler");
+  CHECK(Clay3DS_RegisterCustomHandler(&captureKey, CaptureBlend, NULL), "could not register the blend handler");
+  CHECK(Clay3DS_RegisterLayer((Clay_ElementId){LAYER_ID, 0, LAYER_ID, {0}}), "could not register the layer");
+
+  Clay_RenderCommand commands[3] = {{0}, MakeCustom(&meshConfig, (Clay_BoundingBox){10.f, 10.f, 40.f, 40.f}),
+                                    MakeCustom(&captureConfig, (Clay_BoundingBox){60.f, 10.f, 20.f, 20.f})};
+  commands[0].boundingBox = (Clay_BoundingBox){0.f, 0.f, 100.f, 100.f};
+  commands[0].config.rectangleElementConfig = &background;
+  commands[0].id = LAYER_ID;
+  commands[0].commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE;
+
+  Mock_Reset();
+  Clay3DS_Render(NULL, (Clay_Dimensions){400, 240}, (Clay_RenderCommandArray){3, 3, commands});
+  CHECK(mock_counters.arrayVertices == 6 && mock_counters.buffer == mesh->vertices, "the mesh was not drawn to the layer");
+  CHECK(capturedBlend[0] == GPU_SRC_ALPHA && capturedBlend[1] == GPU_ONE, "the layer blending was lost after the mesh");
+  CHECK(mock_counters.blend[0] == GPU_SRC_ALPHA && mock_counters.blend[1] == GPU_SRC_ALPHA, "the blending was not restored");
+
+  // An empty mesh draws nothing.
+  Clay3DS_MeshClear(mesh);
+  Mock_Reset();
+  Clay3DS_DrawMesh(mesh, (Clay_BoundingBox){20.f, 20.f, 40.f, 30.f});
+  CHECK(mock_counters.arrayVertices == 0 && mock_counters.triangles == 0, "an empty mesh was drawn");
+
+  Clay3DS_MeshDelete(mesh);
+  return TEST_RESULT();
+}
@@ -0,0 +1,106 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Minimal host replacement for libctru, declaring only what the renderer uses.
+
+#ifndef __MOCK_3DS_H
+#define __MOCK_3DS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef s32 Result;
+
+#define U64_MAX UINT64_MAX
+#define CUR_THREAD_HANDLE 0xFFFF8000
+#define KEY_A (1u << 0)
+#define KEY_TOUCH (1u << 20)
+
+typedef struct
+{
+  u16 px;
+  u16 py;
+} touchPosition;
+
+typedef struct
+{
+  u8 fontType;
+  s8 height;
+  s8 width;
+  s8 maxWidth;
+  s8 lineFeed;
+} FINF_s;
+
+#define GLYPH_POS_CALC_VTXCOORD (1 << 0)
+
+typedef struct
+{
+  int sheetIndex;
+  float xOffset;
+  float xAdvance;
+  float width;
+  struct
+  {
+    float left, top, right, bottom;
+  } texcoord;
+  struct
+  {
+    float left, top, right, bottom;
+  } vtx;
+} fontGlyphPos_s;
+
+ssize_t decode_utf8(u32* out, const u8* in);
+u32 hidKeysHeld(void);
+void hidTouchRead(touchPosition* touch);
+u64 osGetTime(void);
+void* linearAlloc(size_t size);
+void linearFree(void* data);
+Result GSPGPU_FlushDataCache(const void* address, u32 size);
+
+typedef struct Mock_Thread* Thread;
+typedef void (*ThreadFunc)(void* arg);
+
+Thread threadCreate(ThreadFunc entrypoint, void* arg, size_t stackSize, int priority, int coreId, bool detached);
+Result threadJoin(Thread thread, u64 timeout);
+void threadFree(Thread thread);
+Result svcGetThreadPriority(s32* priority, u32 handle);
+
+typedef pthread_mutex_t LightLock;
+
+void LightLock_Init(LightLock* lock);
+void LightLock_Lock(LightLock* lock);
+void LightLock_Unlock(LightLock* lock);
+
+typedef enum
+{
+  RESET_ONESHOT,
+  RESET_STICKY,
+} ResetType;
+
+typedef struct
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  bool signaled;
+} LightEvent;
+
+void LightEvent_Init(LightEvent* event, ResetType type);
+void LightEvent_Signal(LightEvent* event);
+void LightEvent_Wait(LightEvent* event);
+
+#endif // __MOCK_3DS_H
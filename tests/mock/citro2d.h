@@ -0,0 +1,94 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Minimal host replacement for citro2d, declaring only what the renderer uses.
+
+#ifndef __MOCK_CITRO2D_H
+#define __MOCK_CITRO2D_H
+
+#include "citro3d.h"
+
+#define C2D_WithColor (1 << 2)
+
+typedef struct
+{
+  C3D_Tex* tex;
+  const Tex3DS_SubTexture* subtex;
+} C2D_Image;
+
+typedef struct
+{
+  struct
+  {
+    float x, y, w, h;
+  } pos;
+  struct
+  {
+    float x, y;
+  } center;
+  float depth;
+  float angle;
+} C2D_DrawParams;
+
+typedef struct
+{
+  u32 color;
+  float blend;
+} C2D_Tint;
+
+typedef struct
+{
+  C2D_Tint corners[4];
+} C2D_ImageTint;
+
+typedef struct Mock_Font* C2D_Font;
+typedef struct Mock_TextBuf* C2D_TextBuf;
+
+typedef struct
+{
+  C2D_TextBuf buf;
+  size_t begin;
+  size_t end;
+  float width;
+  u32 lines;
+  u32 words;
+  C2D_Font font;
+} C2D_Text;
+
+static inline u32 C2D_Color32(u8 r, u8 g, u8 b, u8 a)
+{
+  return r | (g << 8) | (b << 16) | ((u32)a << 24);
+}
+
+bool C2D_DrawTriangle(float x0, float y0, u32 clr0, float x1, float y1, u32 clr1, float x2, float y2, u32 clr2, float depth);
+bool C2D_DrawRectSolid(float x, float y, float z, float w, float h, u32 clr);
+bool C2D_DrawImage(C2D_Image img, const C2D_DrawParams* params, const C2D_ImageTint* tint);
+void C2D_PlainImageTint(C2D_ImageTint* tint, u32 color, float blend);
+
+C2D_TextBuf C2D_TextBufNew(size_t maxGlyphs);
+void C2D_TextBufClear(C2D_TextBuf buf);
+const char* C2D_TextFontParse(C2D_Text* text, C2D_Font font, C2D_TextBuf buf, const char* str);
+void C2D_TextOptimize(const C2D_Text* text);
+void C2D_TextGetDimensions(const C2D_Text* text, float scaleX, float scaleY, float* outWidth, float* outHeight);
+void C2D_DrawText(const C2D_Text* text, u32 flags, float x, float y, float z, float scaleX, float scaleY, ...);
+
+FINF_s* C2D_FontGetInfo(C2D_Font font);
+int C2D_FontGlyphIndexFromCodePoint(C2D_Font font, u32 codepoint);
+void C2D_FontCalcGlyphPos(C2D_Font font, fontGlyphPos_s* out, int glyphIndex, u32 flags, float scaleX, float scaleY);
+C3D_Tex* C2D_FontGetSheet(C2D_Font font, int sheetIndex);
+
+void C2D_Prepare(void);
+void C2D_SceneBegin(C3D_RenderTarget* target);
+void C2D_TargetClear(C3D_RenderTarget* target, u32 color);
+void C2D_Flush(void);
+void C2D_ViewReset(void);
+void C2D_ViewSave(C3D_Mtx* matrix);
+void C2D_ViewRestore(const C3D_Mtx* matrix);
+void C2D_ViewTranslate(float x, float y);
+void C2D_ViewScale(float x, float y);
+
+#endif // __MOCK_CITRO2D_H
@@ -0,0 +1,130 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Minimal host replacement for citro3d and tex3ds, declaring only what the renderer uses.
+
+#ifndef __MOCK_CITRO3D_H
+#define __MOCK_CITRO3D_H
+
+#include "3ds.h"
+
+typedef enum
+{
+  GPU_SCISSOR_DISABLE,
+  GPU_SCISSOR_INVERT,
+  GPU_SCISSOR_NORMAL,
+} GPU_SCISSORMODE;
+
+typedef enum
+{
+  GPU_BLEND_ADD,
+} GPU_BLENDEQUATION;
+
+typedef enum
+{
+  GPU_ZERO,
+  GPU_ONE,
+  GPU_SRC_ALPHA = 6,
+  GPU_ONE_MINUS_SRC_ALPHA = 7,
+} GPU_BLENDFACTOR;
+
+typedef enum
+{
+  GPU_TRIANGLES = 0x0000,
+} GPU_Primitive_t;
+
+typedef struct
+{
+  u32 base_paddr;
+  int bufCount;
+  struct
+  {
+    const void* data;
+    u32 stride;
+    int attribCount;
+    u64 permutation;
+  } buffers[12];
+} C3D_BufInfo;
+
+typedef enum
+{
+  GPU_RGBA8 = 0,
+  GPU_A8 = 8,
+} GPU_TEXCOLOR;
+
+typedef enum
+{
+  GPU_NEAREST,
+  GPU_LINEAR,
+} GPU_TEXTURE_FILTER_PARAM;
+
+typedef enum
+{
+  GPU_CLAMP_TO_EDGE,
+} GPU_TEXTURE_WRAP_PARAM;
+
+typedef enum
+{
+  GPU_TEXFACE_2D,
+} GPU_TEXFACE;
+
+typedef struct
+{
+  void* data;
+  u32 size;
+  u16 width;
+  u16 height;
+  GPU_TEXCOLOR fmt;
+} C3D_Tex;
+
+typedef struct
+{
+  C3D_Tex* tex;
+} C3D_RenderTarget;
+
+typedef struct
+{
+  float r[16];
+} C3D_Mtx;
+
+C3D_BufInfo* C3D_GetBufInfo(void);
+void BufInfo_Init(C3D_BufInfo* info);
+int BufInfo_Add(C3D_BufInfo* info, const void* data, ptrdiff_t stride, int attribCount, u64 permutation);
+void C3D_DrawArrays(GPU_Primitive_t primitive, int first, int size);
+
+u32 C3D_FrameCounter(int id);
+void C3D_SetScissor(GPU_SCISSORMODE mode, u32 left, u32 top, u32 right, u32 bottom);
+void C3D_AlphaBlend(GPU_BLENDEQUATION colorEq, GPU_BLENDEQUATION alphaEq, GPU_BLENDFACTOR srcClr, GPU_BLENDFACTOR dstClr,
+                    GPU_BLENDFACTOR srcAlpha, GPU_BLENDFACTOR dstAlpha);
+
+bool C3D_TexInit(C3D_Tex* tex, u16 width, u16 height, GPU_TEXCOLOR format);
+bool C3D_TexInitVRAM(C3D_Tex* tex, u16 width, u16 height, GPU_TEXCOLOR format);
+void C3D_TexDelete(C3D_Tex* tex);
+void C3D_TexFlush(C3D_Tex* tex);
+void C3D_TexSetFilter(C3D_Tex* tex, GPU_TEXTURE_FILTER_PARAM magFilter, GPU_TEXTURE_FILTER_PARAM minFilter);
+void C3D_TexSetWrap(C3D_Tex* tex, GPU_TEXTURE_WRAP_PARAM wrapS, GPU_TEXTURE_WRAP_PARAM wrapT);
+
+C3D_RenderTarget* C3D_RenderTargetCreateFromTex(C3D_Tex* tex, GPU_TEXFACE face, int level, int depthFormat);
+void C3D_RenderTargetDelete(C3D_RenderTarget* target);
+
+typedef struct
+{
+  u16 width;
+  u16 height;
+  float left;
+  float top;
+  float right;
+  float bottom;
+} Tex3DS_SubTexture;
+
+typedef struct Mock_Tex3DS* Tex3DS_Texture;
+
+Tex3DS_Texture Tex3DS_TextureImport(const void* input, size_t size, C3D_Tex* tex, void* texcube, bool vram);
+void Tex3DS_TextureFree(Tex3DS_Texture texture);
+const Tex3DS_SubTexture* Tex3DS_GetSubTexture(Tex3DS_Texture texture, size_t index);
+
+#endif // __MOCK_CITRO3D_H
@@ -0,0 +1,165 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Minimal host replacement for clay.h, declaring only the types the renderer consumes.
+// The host tests build render commands by hand, so no layout code is needed.
+
+#ifndef __MOCK_CLAY_H
+#define __MOCK_CLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+  int32_t length;
+  const char* chars;
+} Clay_String;
+
+typedef struct
+{
+  float width;
+  float height;
+} Clay_Dimensions;
+
+typedef struct
+{
+  float x;
+  float y;
+} Clay_Vector2;
+
+typedef struct
+{
+  float r;
+  float g;
+  float b;
+  float a;
+} Clay_Color;
+
+typedef struct
+{
+  float x;
+  float y;
+  float width;
+  float height;
+} Clay_BoundingBox;
+
+typedef struct
+{
+  float topLeft;
+  float topRight;
+  float bottomLeft;
+  float bottomRight;
+} Clay_CornerRadius;
+
+typedef struct
+{
+  uint32_t id;
+  uint32_t offset;
+  uint32_t baseId;
+  Clay_String stringId;
+} Clay_ElementId;
+
+typedef struct
+{
+  Clay_Color color;
+  Clay_CornerRadius cornerRadius;
+} Clay_RectangleElementConfig;
+
+typedef struct
+{
+  Clay_Color textColor;
+  uint16_t fontId;
+  uint16_t fontSize;
+  uint16_t letterSpacing;
+  uint16_t lineHeight;
+  int wrapMode;
+} Clay_TextElementConfig;
+
+typedef struct
+{
+  void* imageData;
+  Clay_Dimensions sourceDimensions;
+} Clay_ImageElementConfig;
+
+typedef struct
+{
+  void* customData;
+} Clay_CustomElementConfig;
+
+typedef struct
+{
+  uint32_t width;
+  Clay_Color color;
+} Clay_Border;
+
+typedef struct
+{
+  Clay_Border left;
+  Clay_Border right;
+  Clay_Border top;
+  Clay_Border bottom;
+  Clay_Border betweenChildren;
+  Clay_CornerRadius cornerRadius;
+} Clay_BorderElementConfig;
+
+typedef struct
+{
+  bool horizontal;
+  bool vertical;
+} Clay_ScrollElementConfig;
+
+typedef union {
+  Clay_RectangleElementConfig* rectangleElementConfig;
+  Clay_TextElementConfig* textElementConfig;
+  Clay_ImageElementConfig* imageElementConfig;
+  Clay_CustomElementConfig* customElementConfig;
+  Clay_ScrollElementConfig* scrollElementConfig;
+  Clay_BorderElementConfig* borderElementConfig;
+} Clay_ElementConfigUnion;
+
+typedef enum
+{
+  CLAY_RENDER_COMMAND_TYPE_NONE,
+  CLAY_RENDER_COMMAND_TYPE_RECTANGLE,
+  CLAY_RENDER_COMMAND_TYPE_BORDER,
+  CLAY_RENDER_COMMAND_TYPE_TEXT,
+  CLAY_RENDER_COMMAND_TYPE_IMAGE,
+  CLAY_RENDER_COMMAND_TYPE_SCISSOR_START,
+  CLAY_RENDER_COMMAND_TYPE_SCISSOR_END,
+  CLAY_RENDER_COMMAND_TYPE_CUSTOM,
+} Clay_RenderCommandType;
+
+typedef struct
+{
+  Clay_BoundingBox boundingBox;
+  Clay_ElementConfigUnion config;
+  Clay_String text;
+  uint32_t id;
+  Clay_RenderCommandType commandType;
+} Clay_RenderCommand;
+
+typedef struct
+{
+  uint32_t capacity;
+  uint32_t length;
+  Clay_RenderCommand* internalArray;
+} Clay_RenderCommandArray;
+
+typedef struct
+{
+  Clay_Vector2* scrollPosition;
+  Clay_Dimensions scrollContainerDimensions;
+  Clay_Dimensions contentDimensions;
+  Clay_ScrollElementConfig config;
+  bool found;
+} Clay_ScrollContainerData;
+
+Clay_RenderCommand* Clay_RenderCommandArray_Get(Clay_RenderCommandArray* array, int32_t index);
+Clay_ScrollContainerData Clay_GetScrollContainerData(Clay_ElementId id);
+
+#endif // __MOCK_CLAY_H
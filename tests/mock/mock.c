@@ -0,0 +1,673 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+#include "mock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MOCK_TEXTURE_MAGIC "MT3X"
+#define MOCK_BUFFER_SIZE (1 << 20)
+
+// Vertex in the layout of the citro2d vertex buffer.
+typedef struct
+{
+  float position[3];
+  float texcoord[2];
+  float blend[2];
+  u32 color;
+} Mock_Vertex;
+
+Mock_Counters mock_counters;
+Mock_Triangle mock_triangles[MOCK_MAX_TRIANGLES];
+Mock_Image mock_images[MOCK_MAX_IMAGES];
+bool mock_record = true;
+u32 mock_frameCounter = 0;
+u32 mock_keys = 0;
+touchPosition mock_touch = {0, 0};
+Clay_Vector2* mock_scrollPosition = NULL;
+
+void Mock_Reset(void)
+{
+  memset(&mock_counters, 0, sizeof(mock_counters));
+  mock_counters.blend[0] = GPU_SRC_ALPHA;
+  mock_counters.blend[1] = GPU_SRC_ALPHA;
+}
+
+static float Mock_Edge(float ax, float ay, float bx, float by, float px, float py)
+{
+  return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+void Mock_Rasterize(float* coverage, int width, int height)
+{
+  memset(coverage, 0, sizeof(float) * width * height);
+
+  u32 count = mock_counters.triangles < MOCK_MAX_TRIANGLES ? mock_counters.triangles : MOCK_MAX_TRIANGLES;
+  for (u32 i = 0; i < count; ++i)
+  {
+    const Mock_Triangle* t = &mock_triangles[i];
+    float area = Mock_Edge(t->x[0], t->y[0], t->x[1], t->y[1], t->x[2], t->y[2]);
+    if (area > -1e-9f && area < 1e-9f)
+    {
+      continue;
+    }
+
+    for (int y = 0; y < height; ++y)
+    {
+      for (int x = 0; x < width; ++x)
+      {
+        float px = x + 0.5f;
+        float py = y + 0.5f;
+        float w0 = Mock_Edge(t->x[1], t->y[1], t->x[2], t->y[2], px, py) / area;
+        float w1 = Mock_Edge(t->x[2], t->y[2], t->x[0], t->y[0], px, py) / area;
+        float w2 = Mock_Edge(t->x[0], t->y[0], t->x[1], t->y[1], px, py) / area;
+        if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+        {
+          continue;
+        }
+
+        float alpha = (w0 * (t->color[0] >> 24) + w1 * (t->color[1] >> 24) + w2 * (t->color[2] >> 24)) / 255.f;
+        float* pixel = &coverage[y * width + x];
+        *pixel = alpha + (1.f - alpha) * *pixel;
+      }
+    }
+  }
+}
+
+// Like citro2d, the vertices of every shape are written to a vertex and an index buffer, so that the benchmarks pay
+// for the same memory traffic as on the console. They fit the vertices of a whole benchmark frame, like the citro2d
+// buffers must, and only wrap around after that. They are not static, or the compiler could drop the writes, as
+// nothing reads them.
+Mock_Vertex mock_vertexBuffer[MOCK_BUFFER_SIZE];
+u16 mock_indexBuffer[MOCK_BUFFER_SIZE];
+u32 mock_bufferPosition = 0;
+
+static void Mock_AppendVertex(float x, float y, u32 color)
+{
+  u32 index = mock_bufferPosition++ % MOCK_BUFFER_SIZE;
+  mock_vertexBuffer[index] = (Mock_Vertex){{x, y, 0.f}, {-1.f, 1.f}, {0.f, 1.f}, color};
+  mock_indexBuffer[index] = (u16)index;
+}
+
+static void Mock_Record(float x0, float y0, u32 c0, float x1, float y1, u32 c1, float x2, float y2, u32 c2)
+{
+  if (mock_record && mock_counters.triangles < MOCK_MAX_TRIANGLES)
+  {
+    mock_triangles[mock_counters.triangles] = (Mock_Triangle){{x0, x1, x2}, {y0, y1, y2}, {c0, c1, c2}};
+  }
+  mock_counters.triangles++;
+}
+
+// ================================
+// citro2d
+// ================================
+
+bool C2D_DrawTriangle(float x0, float y0, u32 clr0, float x1, float y1, u32 clr1, float x2, float y2, u32 clr2, float depth)
+{
+  (void)depth;
+  Mock_AppendVertex(x0, y0, clr0);
+  Mock_AppendVertex(x1, y1, clr1);
+  Mock_AppendVertex(x2, y2, clr2);
+  Mock_Record(x0, y0, clr0, x1, y1, clr1, x2, y2, clr2);
+  return true;
+}
+
+bool C2D_DrawRectSolid(float x, float y, float z, float w, float h, u32 clr)
+{
+  (void)z;
+  mock_counters.rects++;
+  Mock_AppendVertex(x, y, clr);
+  Mock_AppendVertex(x + w, y, clr);
+  Mock_AppendVertex(x, y + h, clr);
+  Mock_AppendVertex(x + w, y + h, clr);
+  Mock_Record(x, y, clr, x + w, y, clr, x, y + h, clr);
+  Mock_Record(x + w, y, clr, x + w, y + h, clr, x, y + h, clr);
+  return true;
+}
+
+bool C2D_DrawImage(C2D_Image img, const C2D_DrawParams* params, const C2D_ImageTint* tint)
+{
+  (void)tint;
+  if (mock_record && mock_counters.images < MOCK_MAX_IMAGES)
+  {
+    Mock_Image* image = &mock_images[mock_counters.images];
+    image->tex = img.tex;
+    image->subtex = *img.subtex;
+    image->rect[0] = params->pos.x;
+    image->rect[1] = params->pos.y;
+    image->rect[2] = params->pos.w;
+    image->rect[3] = params->pos.h;
+  }
+  mock_counters.images++;
+  return true;
+}
+
+void C2D_PlainImageTint(C2D_ImageTint* tint, u32 color, float blend)
+{
+  for (int i = 0; i < 4; ++i)
+  {
+    tint->corners[i] = (C2D_Tint){color, blend};
+  }
+}
+
+C2D_TextBuf C2D_TextBufNew(size_t maxGlyphs)
+{
+  (void)maxGlyphs;
+  return NULL;
+}
+
+void C2D_TextBufClear(C2D_TextBuf buf)
+{
+  (void)buf;
+}
+
+const char* C2D_TextFontParse(C2D_Text* text, C2D_Font font, C2D_TextBuf buf, const char* str)
+{
+  memset(text, 0, sizeof(*text));
+  text->font = font;
+  text->buf = buf;
+  return str + strlen(str);
+}
+
+void C2D_TextOptimize(const C2D_Text* text)
+{
+  (void)text;
+}
+
+void C2D_TextGetDimensions(const C2D_Text* text, float scaleX, float scaleY, float* outWidth, float* outHeight)
+{
+  (void)text;
+  (void)scaleX;
+  (void)scaleY;
+  *outWidth = 0.f;
+  *outHeight = 0.f;
+}
+
+void C2D_DrawText(const C2D_Text* text, u32 flags, float x, float y, float z, float scaleX, float scaleY, ...)
+{
+  (void)text;
+  (void)flags;
+  (void)x;
+  (void)y;
+  (void)z;
+  (void)scaleX;
+  (void)scaleY;
+  mock_counters.texts++;
+}
+
+FINF_s* C2D_FontGetInfo(C2D_Font font)
+{
+  (void)font;
+  static FINF_s info = {0, MOCK_GLYPH_HEIGHT, MOCK_GLYPH_WIDTH, MOCK_GLYPH_WIDTH, MOCK_LINE_FEED};
+  return &info;
+}
+
+int C2D_FontGlyphIndexFromCodePoint(C2D_Font font, u32 codepoint)
+{
+  (void)font;
+  return codepoint < 128 ? (int)codepoint : '?';
+}
+
+void C2D_FontCalcGlyphPos(C2D_Font font, fontGlyphPos_s* out, int glyphIndex, u32 flags, float scaleX, float scaleY)
+{
+  (void)font;
+  (void)flags;
+  int cell = glyphIndex % 64;
+  float u = (cell % 8) * 32.f / MOCK_SHEET_SIZE;
+  float v = 1.f - (cell / 8) * 32.f / MOCK_SHEET_SIZE;
+
+  out->sheetIndex = glyphIndex / 64;
+  out->xOffset = MOCK_GLYPH_OFFSET * scaleX;
+  out->xAdvance = MOCK_GLYPH_ADVANCE * scaleX;
+  out->width = MOCK_GLYPH_WIDTH * scaleX;
+  out->texcoord.left = u;
+  out->texcoord.top = v;
+  out->texcoord.right = u + (float)MOCK_GLYPH_WIDTH / MOCK_SHEET_SIZE;
+  out->texcoord.bottom = v - (float)MOCK_GLYPH_HEIGHT / MOCK_SHEET_SIZE;
+  out->vtx.left = out->xOffset;
+  out->vtx.top = 0.f;
+  out->vtx.right = out->xOffset + out->width;
+  out->vtx.bottom = MOCK_GLYPH_HEIGHT * scaleY;
+}
+
+C3D_Tex* C2D_FontGetSheet(C2D_Font font, int sheetIndex)
+{
+  (void)font;
+  static C3D_Tex sheets[2];
+  C3D_Tex* sheet = &sheets[sheetIndex % 2];
+  sheet->width = MOCK_SHEET_SIZE;
+  sheet->height = MOCK_SHEET_SIZE;
+  sheet->fmt = GPU_A8;
+  return sheet;
+}
+
+void C2D_Prepare(void)
+{
+  // Like citro2d, preparing the GPU also restores the default blending.
+  mock_counters.prepares++;
+  mock_counters.blend[0] = GPU_SRC_ALPHA;
+  mock_counters.blend[1] = GPU_SRC_ALPHA;
+}
+
+void C2D_SceneBegin(C3D_RenderTarget* target)
+{
+  (void)target;
+}
+
+void C2D_TargetClear(C3D_RenderTarget* target, u32 color)
+{
+  (void)target;
+  (void)color;
+}
+
+void C2D_Flush(void)
+{
+  mock_counters.flushes++;
+}
+
+void C2D_ViewReset(void)
+{
+}
+
+void C2D_ViewSave(C3D_Mtx* matrix)
+{
+  memset(matrix, 0, sizeof(*matrix));
+}
+
+void C2D_ViewRestore(const C3D_Mtx* matrix)
+{
+  (void)matrix;
+}
+
+void C2D_ViewTranslate(float x, float y)
+{
+  (void)x;
+  (void)y;
+}
+
+void C2D_ViewScale(float x, float y)
+{
+  (void)x;
+  (void)y;
+}
+
+// ================================
+// citro3d & Tex3DS
+// ================================
+
+struct Mock_Tex3DS
+{
+  Tex3DS_SubTexture subtex;
+};
+
+static C3D_BufInfo mock_bufInfo;
+
+C3D_BufInfo* C3D_GetBufInfo(void)
+{
+  return &mock_bufInfo;
+}
+
+void BufInfo_Init(C3D_BufInfo* info)
+{
+  memset(info, 0, sizeof(*info));
+}
+
+int BufInfo_Add(C3D_BufInfo* info, const void* data, ptrdiff_t stride, int attribCount, u64 permutation)
+{
+  int index = info->bufCount++;
+  info->buffers[index].data = data;
+  info->buffers[index].stride = (u32)stride;
+  info->buffers[index].attribCount = attribCount;
+  info->buffers[index].permutation = permutation;
+  mock_counters.buffer = data;
+  return index;
+}
+
+void C3D_DrawArrays(GPU_Primitive_t primitive, int first, int size)
+{
+  (void)primitive;
+  mock_counters.arrayVertices += size;
+
+  // The bound buffer must hold vertices in the layout of the citro2d ones, whose triangles are recorded. The GPU reads
+  // them on the console, so they are only counted by the benchmarks.
+  if (!mock_record)
+  {
+    mock_counters.triangles += size / 3;
+    return;
+  }
+
+  const u8* data = (const u8*)mock_bufInfo.buffers[0].data;
+  u32 stride = mock_bufInfo.buffers[0].stride;
+  for (int i = first; i + 2 < first + size; i += 3)
+  {
+    const Mock_Vertex* v[3];
+    for (int j = 0; j < 3; ++j)
+    {
+      v[j] = (const Mock_Vertex*)(data + (i + j) * stride);
+    }
+    Mock_Record(v[0]->position[0], v[0]->position[1], v[0]->color, v[1]->position[0], v[1]->position[1], v[1]->color,
+                v[2]->position[0], v[2]->position[1], v[2]->color);
+  }
+}
+
+u32 C3D_FrameCounter(int id)
+{
+  (void)id;
+  return mock_frameCounter;
+}
+
+void C3D_SetScissor(GPU_SCISSORMODE mode, u32 left, u32 top, u32 right, u32 bottom)
+{
+  mock_counters.scissors++;
+  mock_counters.scissorMode = mode;
+  mock_counters.scissor[0] = left;
+  mock_counters.scissor[1] = top;
+  mock_counters.scissor[2] = right;
+  mock_counters.scissor[3] = bottom;
+}
+
+void C3D_AlphaBlend(GPU_BLENDEQUATION colorEq, GPU_BLENDEQUATION alphaEq, GPU_BLENDFACTOR srcClr, GPU_BLENDFACTOR dstClr,
+                    GPU_BLENDFACTOR srcAlpha, GPU_BLENDFACTOR dstAlpha)
+{
+  (void)colorEq;
+  (void)alphaEq;
+  (void)dstClr;
+  (void)dstAlpha;
+  mock_counters.blend[0] = srcClr;
+  mock_counters.blend[1] = srcAlpha;
+}
+
+static bool Mock_TexInit(C3D_Tex* tex, u16 width, u16 height, GPU_TEXCOLOR format)
+{
+  u32 bpp = format == GPU_A8 ? 1 : 4;
+  tex->data = calloc((size_t)width * height, bpp);
+  tex->size = width * height * bpp;
+  tex->width = width;
+  tex->height = height;
+  tex->fmt = format;
+  return tex->data != NULL;
+}
+
+bool C3D_TexInit(C3D_Tex* tex, u16 width, u16 height, GPU_TEXCOLOR format)
+{
+  return Mock_TexInit(tex, width, height, format);
+}
+
+bool C3D_TexInitVRAM(C3D_Tex* tex, u16 width, u16 height, GPU_TEXCOLOR format)
+{
+  return Mock_TexInit(tex, width, height, format);
+}
+
+void C3D_TexDelete(C3D_Tex* tex)
+{
+  free(tex->data);
+  tex->data = NULL;
+}
+
+void C3D_TexFlush(C3D_Tex* tex)
+{
+  (void)tex;
+}
+
+void C3D_TexSetFilter(C3D_Tex* tex, GPU_TEXTURE_FILTER_PARAM magFilter, GPU_TEXTURE_FILTER_PARAM minFilter)
+{
+  (void)tex;
+  (void)magFilter;
+  (void)minFilter;
+}
+
+void C3D_TexSetWrap(C3D_Tex* tex, GPU_TEXTURE_WRAP_PARAM wrapS, GPU_TEXTURE_WRAP_PARAM wrapT)
+{
+  (void)tex;
+  (void)wrapS;
+  (void)wrapT;
+}
+
+C3D_RenderTarget* C3D_RenderTargetCreateFromTex(C3D_Tex* tex, GPU_TEXFACE face, int level, int depthFormat)
+{
+  (void)face;
+  (void)level;
+  (void)depthFormat;
+  C3D_RenderTarget* target = calloc(1, sizeof(C3D_RenderTarget));
+  if (target != NULL)
+  {
+    target->tex = tex;
+  }
+  return target;
+}
+
+void C3D_RenderTargetDelete(C3D_RenderTarget* target)
+{
+  free(target);
+}
+
+bool Mock_WriteTexture(const char* path, u16 width, u16 height)
+{
+  FILE* file = fopen(path, "wb");
+  if (file == NULL)
+  {
+    return false;
+  }
+
+  u16 size[2] = {width, height};
+  bool isWritten = fwrite(MOCK_TEXTURE_MAGIC, 1, 4, file) == 4 && fwrite(size, sizeof(u16), 2, file) == 2;
+  return fclose(file) == 0 && isWritten;
+}
+
+Tex3DS_Texture Tex3DS_TextureImport(const void* input, size_t size, C3D_Tex* tex, void* texcube, bool vram)
+{
+  (void)texcube;
+  (void)vram;
+  u16 dimensions[2];
+  if (size != 4 + sizeof(dimensions) || memcmp(input, MOCK_TEXTURE_MAGIC, 4) != 0)
+  {
+    return NULL;
+  }
+
+  memcpy(dimensions, (const u8*)input + 4, sizeof(dimensions));
+  Tex3DS_Texture texture = calloc(1, sizeof(struct Mock_Tex3DS));
+  if (texture == NULL || !Mock_TexInit(tex, dimensions[0], dimensions[1], GPU_RGBA8))
+  {
+    free(texture);
+    return NULL;
+  }
+
+  texture->subtex = (Tex3DS_SubTexture){dimensions[0], dimensions[1], 0.f, 1.f, 1.f, 0.f};
+  return texture;
+}
+
+void Tex3DS_TextureFree(Tex3DS_Texture texture)
+{
+  free(texture);
+}
+
+const Tex3DS_SubTexture* Tex3DS_GetSubTexture(Tex3DS_Texture texture, size_t index)
+{
+  (void)index;
+  return &texture->subtex;
+}
+
+// ================================
+// libctru
+// ================================
+
+struct Mock_Thread
+{
+  pthread_t handle;
+  ThreadFunc entrypoint;
+  void* arg;
+};
+
+static void* Mock_ThreadMain(void* arg)
+{
+  Thread thread = arg;
+  thread->entrypoint(thread->arg);
+  return NULL;
+}
+
+Thread threadCreate(ThreadFunc entrypoint, void* arg, size_t stackSize, int priority, int coreId, bool detached)
+{
+  (void)stackSize;
+  (void)priority;
+  (void)coreId;
+  (void)detached;
+  Thread thread = calloc(1, sizeof(struct Mock_Thread));
+  if (thread == NULL)
+  {
+    return NULL;
+  }
+
+  thread->entrypoint = entrypoint;
+  thread->arg = arg;
+  if (pthread_create(&thread->handle, NULL, Mock_ThreadMain, thread) != 0)
+  {
+    free(thread);
+    return NULL;
+  }
+  return thread;
+}
+
+Result threadJoin(Thread thread, u64 timeout)
+{
+  (void)timeout;
+  return pthread_join(thread->handle, NULL);
+}
+
+void threadFree(Thread thread)
+{
+  free(thread);
+}
+
+Result svcGetThreadPriority(s32* priority, u32 handle)
+{
+  (void)handle;
+  *priority = 0x30;
+  return 0;
+}
+
+void LightLock_Init(LightLock* lock)
+{
+  pthread_mutex_init(lock, NULL);
+}
+
+void LightLock_Lock(LightLock* lock)
+{
+  pthread_mutex_lock(lock);
+}
+
+void LightLock_Unlock(LightLock* lock)
+{
+  pthread_mutex_unlock(lock);
+}
+
+void LightEvent_Init(LightEvent* event, ResetType type)
+{
+  (void)type;
+  pthread_mutex_init(&event->mutex, NULL);
+  pthread_cond_init(&event->cond, NULL);
+  event->signaled = false;
+}
+
+void LightEvent_Signal(LightEvent* event)
+{
+  pthread_mutex_lock(&event->mutex);
+  event->signaled = true;
+  pthread_cond_signal(&event->cond);
+  pthread_mutex_unlock(&event->mutex);
+}
+
+void LightEvent_Wait(LightEvent* event)
+{
+  pthread_mutex_lock(&event->mutex);
+  while (!event->signaled)
+  {
+    pthread_cond_wait(&event->cond, &event->mutex);
+  }
+  event->signaled = false;
+  pthread_mutex_unlock(&event->mutex);
+}
+
+ssize_t decode_utf8(u32* out, const u8* in)
+{
+  if (in[0] < 0x80)
+  {
+    *out = in[0];
+    return 1;
+  }
+
+  int units = (in[0] & 0xE0) == 0xC0 ? 2 : (in[0] & 0xF0) == 0xE0 ? 3 : (in[0] & 0xF8) == 0xF0 ? 4 : 0;
+  if (units == 0)
+  {
+    return -1;
+  }
+
+  *out = in[0] & (0x7F >> units);
+  for (int i = 1; i < units; ++i)
+  {
+    if ((in[i] & 0xC0) != 0x80)
+    {
+      return -1;
+    }
+    *out = (*out << 6) | (in[i] & 0x3F);
+  }
+  return units;
+}
+
+u32 hidKeysHeld(void)
+{
+  return mock_keys;
+}
+
+void hidTouchRead(touchPosition* touch)
+{
+  *touch = mock_touch;
+}
+
+u64 osGetTime(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (u64)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void* linearAlloc(size_t size)
+{
+  return malloc(size);
+}
+
+void linearFree(void* data)
+{
+  free(data);
+}
+
+Result GSPGPU_FlushDataCache(const void* address, u32 size)
+{
+  (void)address;
+  (void)size;
+  return 0;
+}
+
+// ================================
+// Clay
+// ================================
+
+Clay_RenderCommand* Clay_RenderCommandArray_Get(Clay_RenderCommandArray* array, int32_t index)
+{
+  return index >= 0 && (u32)index < array->length ? &array->internalArray[index] : NULL;
+}
+
+Clay_ScrollContainerData Clay_GetScrollContainerData(Clay_ElementId id)
+{
+  (void)id;
+  Clay_ScrollContainerData data = {0};
+  data.scrollPosition = mock_scrollPosition;
+  data.found = mock_scrollPosition != NULL;
+  return data;
+}
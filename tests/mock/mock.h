@@ -0,0 +1,93 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Recording backend of the host tests. The citro2d draw calls are stored as triangles, that can be
+// rasterized back into a coverage image to check what the renderer would have put on screen.
+
+#ifndef __MOCK_H
+#define __MOCK_H
+
+#include <citro2d.h>
+
+#include "clay.h"
+
+#define MOCK_MAX_TRIANGLES 65536
+#define MOCK_MAX_IMAGES 256
+
+// Metrics of every glyph of the mocked fonts, at a scale of one. The glyph with index i is in the cell i % 64 of the
+// sheet i / 64, whose cells are 32 texels wide and high, in rows of 8.
+#define MOCK_GLYPH_OFFSET 2
+#define MOCK_GLYPH_WIDTH 20
+#define MOCK_GLYPH_ADVANCE 24
+#define MOCK_GLYPH_HEIGHT 30
+#define MOCK_LINE_FEED 32
+#define MOCK_SHEET_SIZE 256
+
+typedef struct
+{
+  float x[3];
+  float y[3];
+  u32 color[3];
+} Mock_Triangle;
+
+typedef struct
+{
+  C3D_Tex* tex;
+  Tex3DS_SubTexture subtex;
+  // Destination rectangle, as x, y, width and height.
+  float rect[4];
+} Mock_Image;
+
+typedef struct
+{
+  // Triangles submitted, including the two of every solid rectangle, and the ones drawn from vertex buffers.
+  u32 triangles;
+  u32 rects;
+  u32 images;
+  // Strings drawn by citro2d as a whole.
+  u32 texts;
+  u32 scissors;
+  u32 flushes;
+  u32 prepares;
+  // Vertices drawn from buffers other than the citro2d one, and the last buffer bound.
+  u32 arrayVertices;
+  const void* buffer;
+  // Last scissor applied, in the rotated coordinates expected by C3D_SetScissor.
+  GPU_SCISSORMODE scissorMode;
+  u32 scissor[4];
+  // Source factors of the last alpha blending set, for the color and the alpha channel.
+  GPU_BLENDFACTOR blend[2];
+} Mock_Counters;
+
+extern Mock_Counters mock_counters;
+extern Mock_Triangle mock_triangles[MOCK_MAX_TRIANGLES];
+extern Mock_Image mock_images[MOCK_MAX_IMAGES];
+// When false the draw calls are only counted, which keeps the benchmarks free of the recording cost.
+extern bool mock_record;
+
+// Value returned by C3D_FrameCounter for every screen.
+extern u32 mock_frameCounter;
+// Input returned by hidKeysHeld and hidTouchRead.
+extern u32 mock_keys;
+extern touchPosition mock_touch;
+// Scroll position returned by Clay_GetScrollContainerData for every id, which reports the container as not found
+// while this is NULL.
+extern Clay_Vector2* mock_scrollPosition;
+
+// Clears the recorded triangles, images and counters.
+void Mock_Reset(void);
+
+// Composites the alpha of the recorded triangles into a coverage image of width * height floats,
+// sampling every pixel at its center like the GPU does.
+void Mock_Rasterize(float* coverage, int width, int height);
+
+// Writes a file that the mocked Tex3DS_TextureImport accepts as a texture of the specified size.
+//
+// @return True if successful, or false if the file could not be written.
+bool Mock_WriteTexture(const char* path, u16 width, u16 height);
+
+#endif // __MOCK_H
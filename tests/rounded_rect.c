@@ -0,0 +1,358 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Checks that rounded rectangles generated from the arc table cover the same pixels, with the same number of
+// triangles, as the original per-corner trigonometry, and that the batch kernel generates the same triangles as the
+// rectangles drawn one by one. Then measures the CPU cost of each path.
+
+#include <time.h>
+
+#include "mock.h"
+
+#define BENCHMARK_RECTS 4000
+#define BENCHMARK_ITERATIONS 50
+// Enough room for the whole benchmark list, with the fringe.
+#define CLAY3DS_MAX_BATCH_VERTICES (BENCHMARK_RECTS * (Clay3DSi__RECT_TRIANGLES + Clay3DSi__FRINGE_TRIANGLES) * 3)
+
+#include "clay3ds.h"
+#include "test.h"
+
+#define WIDTH 160
+#define HEIGHT 120
+#define BATCH_RECTS 24
+#define Reference_DEG_TO_RAD(value) ((value) * (M_PI / 180.f))
+
+// Copy of the rounded rectangle drawing that computed every corner with cos and sin.
+static void Reference_FillQuad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4, u32 color)
+{
+  C2D_DrawTriangle(x1, y1, color, x2, y2, color, x3, y3, color, 0.f);
+  C2D_DrawTriangle(x1, y1, color, x3, y3, color, x4, y4, color, 0.f);
+}
+
+static void Reference_FillArc(float cx, float cy, float radius, float angs, float ange, u32 color)
+{
+  u32 segments = 4;
+
+  float step = Reference_DEG_TO_RAD((ange - angs) / segments);
+  float cosStep = cos(step);
+  float sinStep = sin(step);
+
+  float angle = Reference_DEG_TO_RAD(angs);
+  float cosAngle1 = cos(angle);
+  float sinAngle1 = sin(angle);
+
+  float x1 = cx + radius * cosAngle1;
+  float y1 = cy + radius * sinAngle1;
+
+  for (u32 i = 1; i <= segments; ++i)
+  {
+    float cosAngle2 = cosAngle1 * cosStep - sinAngle1 * sinStep;
+    float sinAngle2 = sinAngle1 * cosStep + cosAngle1 * sinStep;
+    float x2 = cx + radius * cosAngle2;
+    float y2 = cy + radius * sinAngle2;
+
+    C2D_DrawTriangle(cx, cy, color, x1, y1, color, x2, y2, color, 0.f);
+
+    cosAngle1 = cosAngle2;
+    sinAngle1 = sinAngle2;
+    x1 = x2;
+    y1 = y2;
+  }
+}
+
+static void Reference_FillRoundedRect(Clay_BoundingBox box, float tlr, float trr, float brr, float blr, u32 color)
+{
+  float max = Clay3DSi__MIN(box.width, box.height) / 2.f;
+  tlr = Clay3DSi__MIN(tlr, max);
+  trr = Clay3DSi__MIN(trr, max);
+  brr = Clay3DSi__MIN(brr, max);
+  blr = Clay3DSi__MIN(blr, max);
+
+  // clang-format off
+  Reference_FillQuad(box.x + tlr, box.y,
+                     box.x + box.width - trr, box.y,
+                     box.x + box.width - trr, box.y + trr,
+                     box.x + tlr, box.y + tlr,
+                     color); // Top
+  Reference_FillQuad(box.x + box.width - trr, box.y + trr,
+                     box.x + box.width, box.y + trr,
+                     box.x + box.width, box.y + box.height - brr,
+                     box.x + box.width - brr, box.y + box.height - brr,
+                     color); // Right
+  Reference_FillQuad(box.x + blr, box.y + box.height - blr,
+                     box.x + box.width - brr, box.y + box.height - brr,
+                     box.x + box.width - brr, box.y + box.height,
+                     box.x + blr, box.y + box.height,
+                     color); // Bottom
+  Reference_FillQuad(box.x, box.y + tlr,
+                     box.x + tlr, box.y + tlr,
+                     box.x + blr, box.y + box.height - blr,
+                     box.x, box.y + box.height - blr,
+                     color); // Left
+  Reference_FillQuad(box.x + tlr, box.y + tlr,
+                     box.x + box.width - trr, box.y + trr,
+                     box.x + box.width - brr, box.y + box.height - brr,
+                     box.x + blr, box.y + box.height - blr,
+                     color); // Inner
+  // clang-format on
+
+  Reference_FillArc(box.x + tlr, box.y + tlr, tlr, 180.f, 270.f, color);
+  Reference_FillArc(box.x + box.width - trr, box.y + trr, trr, 270.f, 360.f, color);
+  Reference_FillArc(box.x + box.width - brr, box.y + box.height - brr, brr, 0.f, 90.f, color);
+  Reference_FillArc(box.x + blr, box.y + box.height - blr, blr, 90.f, 180.f, color);
+}
+
+static Clay_RenderCommand MakeRect(Clay_RectangleElementConfig* config, Clay_BoundingBox box)
+{
+  Clay_RenderCommand command = {0};
+  command.boundingBox = box;
+  command.config.rectangleElementConfig = config;
+  command.commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE;
+  return command;
+}
+
+static void RenderRects(Clay_RenderCommand* commands, u32 count)
+{
+  Clay_RenderCommandArray array = {count, count, commands};
+  Clay3DS_Render(NULL, (Clay_Dimensions){WIDTH, HEIGHT}, array);
+}
+
+static float TrianglesArea(void)
+{
+  float area = 0.f;
+  for (u32 i = 0; i < mock_counters.triangles; ++i)
+  {
+    const Mock_Triangle* t = &mock_triangles[i];
+    area += fabsf((t->x[1] - t->x[0]) * (t->y[2] - t->y[0]) - (t->y[1] - t->y[0]) * (t->x[2] - t->x[0])) / 2.f;
+  }
+  return area;
+}
+
+static void CheckEquivalence(Clay_BoundingBox box, Clay_CornerRadius radius)
+{
+  static float expected[WIDTH * HEIGHT];
+  static float actual[WIDTH * HEIGHT];
+  u32 color = C2D_Color32(255, 255, 255, 255);
+
+  Mock_Reset();
+  Reference_FillRoundedRect(box, radius.topLeft, radius.topRight, radius.bottomRight, radius.bottomLeft, color);
+  u32 expectedTriangles = mock_counters.triangles;
+  float expectedArea = TrianglesArea();
+  Mock_Rasterize(expected, WIDTH, HEIGHT);
+
+  Clay_RectangleElementConfig config = {{255, 255, 255, 255}, radius};
+  Clay_RenderCommand command = MakeRect(&config, box);
+  Mock_Reset();
+  RenderRects(&command, 1);
+  float actualArea = TrianglesArea();
+  Mock_Rasterize(actual, WIDTH, HEIGHT);
+
+  u32 mismatches = 0;
+  for (u32 i = 0; i < WIDTH * HEIGHT; ++i)
+  {
+    mismatches += fabsf(expected[i] - actual[i]) > 1e-3f;
+  }
+
+  CHECK(mock_counters.triangles == expectedTriangles, "%g,%g %gx%g: %u triangles, expected %u", box.x, box.y, box.width,
+        box.height, mock_counters.triangles, expectedTriangles);
+  CHECK(fabsf(actualArea - expectedArea) < 1e-3f * expectedArea, "%g,%g %gx%g: area %f, expected %f", box.x, box.y, box.width,
+        box.height, actualArea, expectedArea);
+  CHECK(mismatches == 0, "%g,%g %gx%g: %u pixels differ", box.x, box.y, box.width, box.height, mismatches);
+}
+
+// Returns a deterministic pseudo-random value between 0 and 1.
+static float Random(u32* seed)
+{
+  *seed = *seed * 1664525u + 1013904223u;
+  return (float)(*seed >> 8) / (float)(1u << 24);
+}
+
+// Checks that a run of rounded rectangles drawn as a batch, from a single vertex buffer, generates the same triangles
+// as the same rectangles drawn one by one through citro2d.
+static void CheckBatchEquivalence(bool antialiasing)
+{
+  static Clay_RectangleElementConfig configs[BATCH_RECTS];
+  static Clay_RenderCommand commands[BATCH_RECTS];
+  static Mock_Triangle expected[BATCH_RECTS * (Clay3DSi__RECT_TRIANGLES + Clay3DSi__FRINGE_TRIANGLES)];
+
+  u32 seed = 42;
+  for (u32 i = 0; i < BATCH_RECTS; ++i)
+  {
+    Clay_CornerRadius radius = {Random(&seed) * 20.f, Random(&seed) * 20.f, Random(&seed) * 20.f, Random(&seed) * 20.f};
+    configs[i] = (Clay_RectangleElementConfig){{i * 10.f, 255.f - i * 10.f, 128.f, 128.f + i * 5.f}, radius};
+    Clay_BoundingBox box = {Random(&seed) * 100.f, Random(&seed) * 80.f, 1.f + Random(&seed) * 60.f, 1.f + Random(&seed) * 40.f};
+    commands[i] = MakeRect(&configs[i], box);
+  }
+  // Rectangles thinner than the fringe are left aliased, and end the run when anti-aliasing is enabled.
+  commands[0].boundingBox.height = 0.75f;
+
+  Clay3DS_SetAntialiasing(antialiasing);
+  Mock_Reset();
+  for (u32 i = 0; i < BATCH_RECTS; ++i)
+  {
+    RenderRects(&commands[i], 1);
+  }
+  u32 numExpected = mock_counters.triangles;
+  memcpy(expected, mock_triangles, sizeof(Mock_Triangle) * numExpected);
+  CHECK(mock_counters.arrayVertices == 0, "rectangles drawn one by one were batched");
+
+  Mock_Reset();
+  RenderRects(commands, BATCH_RECTS);
+  // The batch adds the empty triangle that sets up the GPU.
+  u32 numActual = mock_counters.triangles - 1;
+  u32 batched = mock_counters.arrayVertices / 3;
+  u32 first = antialiasing ? Clay3DSi__RECT_TRIANGLES : 0;
+  CHECK(numActual == numExpected && batched == numExpected - first, "%s: %u triangles, %u batched, expected %u",
+        antialiasing ? "anti-aliased" : "aliased", numActual, batched, numExpected);
+  if (numActual != numExpected)
+  {
+    return;
+  }
+
+  u32 mismatches = 0;
+  for (u32 i = 0, j = 0; i < numExpected; ++i, ++j)
+  {
+    // The batch begins after the rectangles drawn one by one, with the empty triangle.
+    j += i == first;
+    for (u32 k = 0; k < 3; ++k)
+    {
+      const Mock_Triangle* a = &expected[i];
+      const Mock_Triangle* b = &mock_triangles[j];
+      mismatches += fabsf(a->x[k] - b->x[k]) > 1e-4f || fabsf(a->y[k] - b->y[k]) > 1e-4f || a->color[k] != b->color[k];
+    }
+  }
+  CHECK(mismatches == 0, "%s: %u vertices differ", antialiasing ? "anti-aliased" : "aliased", mismatches);
+}
+
+// Checks that the vectorized kernel computes the same coordinates as the scalar one.
+static void CheckKernelEquivalence(void)
+{
+#ifdef __SSE__
+  static Clay3DSi__RectBatch scalar;
+  static Clay3DSi__RectBatch vectorized;
+
+  u32 seed = 7;
+  scalar.count = Clay3DSi__RECT_BATCH_LANES - 1;
+  scalar.fringe = Clay3DSi__FRINGE_HALF_WIDTH;
+  for (u32 n = 0; n < Clay3DSi__RECT_BATCH_LANES; ++n)
+  {
+    scalar.x[n] = Random(&seed) * 300.f;
+    scalar.y[n] = Random(&seed) * 200.f;
+    scalar.width[n] = 2.f + Random(&seed) * 100.f;
+    scalar.height[n] = 2.f + Random(&seed) * 100.f;
+    float max = Clay3DSi__MIN(scalar.width[n], scalar.height[n]) / 2.f;
+    for (u32 c = 0; c < 4; ++c)
+    {
+      scalar.radius[c][n] = Random(&seed) * max;
+    }
+  }
+  vectorized = scalar;
+
+  Clay3DSi__ComputeRectCoordsScalar(&scalar);
+  Clay3DSi__ComputeRectCoordsSSE(&vectorized);
+  float error = 0.f;
+  for (u32 i = 0; i < Clay3DSi__RECT_COORDS; ++i)
+  {
+    for (u32 n = 0; n < scalar.count; ++n)
+    {
+      error = fmaxf(error, fabsf(scalar.coordX[i][n] - vectorized.coordX[i][n]));
+      error = fmaxf(error, fabsf(scalar.coordY[i][n] - vectorized.coordY[i][n]));
+    }
+  }
+  CHECK(error <= 1e-5f, "the SSE kernel differs from the scalar one by %g", error);
+#else
+  printf("rounded rect: SSE is not available, only the scalar kernel is used\n");
+#endif
+}
+
+static double Seconds(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void Benchmark(bool antialiasing)
+{
+  static Clay_RenderCommand commands[BENCHMARK_RECTS];
+  Clay_RectangleElementConfig config = {{40, 120, 200, 255}, {6, 6, 6, 6}};
+  for (u32 i = 0; i < BENCHMARK_RECTS; ++i)
+  {
+    commands[i] = MakeRect(&config, (Clay_BoundingBox){(float)(i % 100), (float)(i % 80), 48.f, 32.f});
+  }
+
+  Clay3DS_SetAntialiasing(antialiasing);
+  mock_record = false;
+
+  double start = Seconds();
+  for (u32 j = 0; j < BENCHMARK_ITERATIONS; ++j)
+  {
+    for (u32 i = 0; i < BENCHMARK_RECTS; ++i)
+    {
+      Reference_FillRoundedRect(commands[i].boundingBox, 6.f, 6.f, 6.f, 6.f, 0xFFFFFFFF);
+    }
+  }
+  double reference = Seconds() - start;
+
+  // The same list, drawn one by one through citro2d and in a single batch, including the render command dispatch.
+  Clay3DSi__RenderState state;
+  Clay3DSi__InitRenderState(&state, NULL, (Clay_Dimensions){WIDTH, HEIGHT}, 0.f, 0.f, false);
+  start = Seconds();
+  for (u32 j = 0; j < BENCHMARK_ITERATIONS; ++j)
+  {
+    Clay3DS_ResetVertexBudget();
+    for (u32 i = 0; i < BENCHMARK_RECTS; ++i)
+    {
+      Clay3DSi__RenderCommand(&state, &commands[i]);
+    }
+  }
+  double table = Seconds() - start;
+
+  Clay_RenderCommandArray array = {BENCHMARK_RECTS, BENCHMARK_RECTS, commands};
+  Mock_Reset();
+  start = Seconds();
+  for (u32 j = 0; j < BENCHMARK_ITERATIONS; ++j)
+  {
+    Clay3DS_ResetVertexBudget();
+    Clay3DSi__RenderCommands(&state, &array, 0, BENCHMARK_RECTS);
+  }
+  double batch = Seconds() - start;
+  CHECK(mock_counters.arrayVertices > 0 && mock_counters.prepares == BENCHMARK_ITERATIONS, "%u batches drawn in %u frames",
+        mock_counters.prepares, BENCHMARK_ITERATIONS);
+
+  mock_record = true;
+  double count = (double)BENCHMARK_RECTS * BENCHMARK_ITERATIONS;
+  // The trigonometry reference has no fringe, so it is only comparable without anti-aliasing.
+  if (antialiasing)
+  {
+    printf("rounded rect with fringe: arc table %.1f ns, batch %.1f ns (%.1fx)\n", table / count * 1e9, batch / count * 1e9,
+           table / batch);
+  }
+  else
+  {
+    printf("rounded rect: trigonometry %.1f ns, arc table %.1f ns, batch %.1f ns (%.1fx)\n", reference / count * 1e9,
+           table / count * 1e9, batch / count * 1e9, table / batch);
+  }
+}
+
+int main(void)
+{
+  // A pixel center that falls exactly on an arc vertex is covered or not depending on the rounding of cos and sin,
+  // so the fractional boxes keep their vertices off the pixel centers.
+  CheckEquivalence((Clay_BoundingBox){10.f, 10.f, 100.f, 60.f}, (Clay_CornerRadius){8.f, 8.f, 8.f, 8.f});
+  CheckEquivalence((Clay_BoundingBox){20.f, 15.f, 90.f, 40.f}, (Clay_CornerRadius){4.f, 12.f, 0.f, 20.f});
+  CheckEquivalence((Clay_BoundingBox){5.25f, 7.75f, 64.5f, 64.5f}, (Clay_CornerRadius){40.f, 40.f, 40.f, 40.f});
+  CheckEquivalence((Clay_BoundingBox){30.f, 30.f, 24.f, 80.f}, (Clay_CornerRadius){2.f, 3.f, 5.f, 7.f});
+
+  CheckBatchEquivalence(false);
+  CheckBatchEquivalence(true);
+  CheckKernelEquivalence();
+
+  Benchmark(false);
+  Benchmark(true);
+  return TEST_RESULT();
+}
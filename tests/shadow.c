@@ -0,0 +1,105 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Checks that shadows are drawn as a seamless nine-slice of their cached texture, and that the cache only replaces
+// the textures that the GPU is done with.
+
+#include <math.h>
+
+#include "mock.h"
+
+#include "clay3ds.h"
+#include "test.h"
+
+#define EPSILON 1e-4f
+
+static bool Near(float a, float b)
+{
+  return fabsf(a - b) < EPSILON;
+}
+
+// Checks that the slices drawn for the specified shadow tile its area, and sample the whole texture without gaps.
+static void CheckNineSlice(Clay_BoundingBox box, Clay3DS_Shadow shadow)
+{
+  Mock_Reset();
+  Clay3DS_DrawShadow(box, &shadow);
+  CHECK(mock_counters.images == 9, "%u slices drawn", mock_counters.images);
+  if (mock_counters.images != 9)
+  {
+    return;
+  }
+
+  float blur = floorf(shadow.blur + 0.5f);
+  float corner = floorf(shadow.cornerRadius + 0.5f) + 2.f * blur;
+  float size = mock_images[0].tex->width;
+  for (u32 i = 0; i < 9; ++i)
+  {
+    const Mock_Image* image = &mock_images[i];
+    u32 row = i / 3;
+    u32 col = i % 3;
+    CHECK(image->tex == mock_images[0].tex, "slice %u uses another texture", i);
+
+    // The destination slices start at the blurred edges, and are adjacent in rows and columns.
+    float x = col == 0 ? box.x + shadow.offset.x - blur : mock_images[i - 1].rect[0] + mock_images[i - 1].rect[2];
+    float y = row == 0 ? box.y + shadow.offset.y - blur : mock_images[i - 3].rect[1] + mock_images[i - 3].rect[3];
+    CHECK(Near(image->rect[0], x) && Near(image->rect[1], y), "slice %u is at %g,%g instead of %g,%g", i, image->rect[0],
+          image->rect[1], x, y);
+
+    // So are the source slices, that go from the first to the last texel, flipped vertically like every texture.
+    float left = col == 0 ? 0.f : mock_images[i - 1].subtex.right;
+    float top = row == 0 ? 1.f : mock_images[i - 3].subtex.bottom;
+    CHECK(Near(image->subtex.left, left) && Near(image->subtex.top, top), "slice %u samples from %g,%g instead of %g,%g", i,
+          image->subtex.left, image->subtex.top, left, top);
+    CHECK(col != 2 || Near(image->subtex.right, 1.f), "slice %u ends at u %g", i, image->subtex.right);
+    CHECK(row != 2 || Near(image->subtex.bottom, 0.f), "slice %u ends at v %g", i, image->subtex.bottom);
+
+    // Corners are drawn unscaled.
+    float texelsX = (image->subtex.right - image->subtex.left) * size;
+    float texelsY = (image->subtex.top - image->subtex.bottom) * size;
+    CHECK(col == 1 || (Near(texelsX, corner) && Near(image->rect[2], corner)), "slice %u is %g texels and %g pixels wide", i,
+          texelsX, image->rect[2]);
+    CHECK(row == 1 || (Near(texelsY, corner) && Near(image->rect[3], corner)), "slice %u is %g texels and %g pixels high", i,
+          texelsY, image->rect[3]);
+  }
+
+  const Mock_Image* last = &mock_images[8];
+  CHECK(Near(last->rect[0] + last->rect[2], box.x + shadow.offset.x + box.width + blur) &&
+          Near(last->rect[1] + last->rect[3], box.y + shadow.offset.y + box.height + blur),
+        "the slices do not end at the blurred edges");
+}
+
+int main(void)
+{
+  Clay3DS_Shadow shadow = {{0, 0, 0, 128}, 8.f, 4.f, {2.f, 3.f}};
+  CheckNineSlice((Clay_BoundingBox){40.f, 30.f, 100.f, 60.f}, shadow);
+  shadow.blur = 0.f;
+  CheckNineSlice((Clay_BoundingBox){10.f, 20.f, 32.f, 90.f}, shadow);
+
+  // The cache fills up if it is never told that a frame has ended, as every texture could still be in use. Two of
+  // the entries already hold the shadows above.
+  shadow.blur = 1.f;
+  for (u32 i = 0; i < Clay3DSi__MAX_SHADOWS; ++i)
+  {
+    shadow.cornerRadius = (float)i;
+    Mock_Reset();
+    Clay3DS_DrawShadow((Clay_BoundingBox){0.f, 0.f, 80.f, 80.f}, &shadow);
+    CHECK((mock_counters.images == 9) == (i < Clay3DSi__MAX_SHADOWS - 2), "shadow %u drew %u slices", i, mock_counters.images);
+  }
+
+  // Textures drawn in the previous frame are still protected, and older ones are replaced.
+  Clay3DS_ShadowCacheUpdate();
+  Mock_Reset();
+  Clay3DS_DrawShadow((Clay_BoundingBox){0.f, 0.f, 80.f, 80.f}, &shadow);
+  CHECK(mock_counters.images == 0, "a texture of the previous frame was replaced");
+
+  Clay3DS_ShadowCacheUpdate();
+  Mock_Reset();
+  Clay3DS_DrawShadow((Clay_BoundingBox){0.f, 0.f, 80.f, 80.f}, &shadow);
+  CHECK(mock_counters.images == 9, "no texture was replaced two frames later");
+
+  return TEST_RESULT();
+}
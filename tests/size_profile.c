@@ -0,0 +1,42 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Translation unit of a typical application, compiled once for each feature switch to compare the object sizes.
+// It is never linked, so the functions below are only kept alive by their external linkage.
+
+#include "mock.h"
+
+#include "clay3ds.h"
+
+static void DrawCustom(Clay_RenderCommand* command, void* userData)
+{
+  (void)command;
+  (void)userData;
+}
+
+void SizeProfile_Init(C2D_Font font, Clay_ElementId layer, void* customData)
+{
+  Clay3DS_SetAntialiasing(true);
+  Clay3DS_SetVertexBudget(4096);
+  Clay3DS_RegisterFont(font);
+  Clay3DS_RegisterCustomHandler(customData, DrawCustom, NULL);
+  Clay3DS_RegisterLayer(layer);
+  Clay3DS_ImageCacheInit(1024 * 1024);
+}
+
+Clay_Dimensions SizeProfile_Measure(Clay_String* string, Clay_TextElementConfig* config)
+{
+  return Clay3DS_MeasureText(string, config);
+}
+
+void SizeProfile_Frame(C3D_RenderTarget* target, Clay_Dimensions dimensions, Clay_RenderCommandArray commands)
+{
+  Clay3DS_ResetVertexBudget();
+  Clay3DS_ImageCacheUpdate();
+  Clay3DS_ShadowCacheUpdate();
+  Clay3DS_Render(target, dimensions, commands);
+}
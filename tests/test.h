@@ -0,0 +1,32 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Assertions shared by the host tests. Failed checks are reported and counted, so that a test runs to its end.
+
+#ifndef __TEST_H
+#define __TEST_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition, ...)                                                                                                         \
+  do                                                                                                                                  \
+  {                                                                                                                                   \
+    if (!(condition))                                                                                                                 \
+    {                                                                                                                                 \
+      fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);                                                                                 \
+      fprintf(stderr, __VA_ARGS__);                                                                                                   \
+      fprintf(stderr, "\n");                                                                                                          \
+      failures++;                                                                                                                     \
+    }                                                                                                                                 \
+  } while (0)
+
+// Exit code of a test, which fails if any check did.
+#define TEST_RESULT() (failures == 0 ? 0 : 1)
+
+#endif // __TEST_H
@@ -0,0 +1,97 @@
+// This file is part of the Clay3DS project.
+//
+// (c) 2025 Tommaso Dimatore
+//
+// For the full copyright and license information, please view the LICENSE
+// file that was distributed with this source code.
+
+// Checks that the vertex budget counts the peak usage, restarts with every frame, and simplifies or rejects the draws
+// that do not fit in the citro2d buffers.
+
+#include "mock.h"
+
+#include "clay3ds.h"
+#include "test.h"
+
+// Objects used by a single rounded rectangle, without anti-aliasing.
+#define ROUNDED_OBJECTS Clay3DSi__CountObjects(Clay3DSi__RECT_TRIANGLES * 3, Clay3DSi__RECT_TRIANGLES * 3)
+
+static Clay_RectangleElementConfig rounded = {{255, 255, 255, 255}, {8.f, 8.f, 8.f, 8.f}};
+static Clay_RectangleElementConfig plain = {{255, 255, 255, 255}, {0.f, 0.f, 0.f, 0.f}};
+
+// Renders the specified number of rectangles with the given configuration.
+static void DrawRects(Clay_RectangleElementConfig* config, u32 count)
+{
+  Clay_RenderCommand command = {0};
+  command.boundingBox = (Clay_BoundingBox){10.f, 10.f, 100.f, 60.f};
+  command.config.rectangleElementConfig = config;
+  command.commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE;
+  Clay_RenderCommandArray array = {1, 1, &command};
+  for (u32 i = 0; i < count; ++i)
+  {
+    Clay3DS_Render(NULL, (Clay_Dimensions){400, 240}, array);
+  }
+}
+
+int main(void)
+{
+  Clay3DS_SetAntialiasing(false);
+
+  // Without a budget the usage is only counted, and the peak is kept across frames.
+  DrawRects(&rounded, 3);
+  Clay3DS_VertexStats stats = Clay3DS_GetVertexStats();
+  u32 peak = Clay3DSi__CountObjects(3 * Clay3DSi__RECT_TRIANGLES * 3, 3 * Clay3DSi__RECT_TRIANGLES * 3);
+  CHECK(stats.usedObjects == peak && stats.peakObjects == peak, "%u objects used, %u at peak", stats.usedObjects,
+        stats.peakObjects);
+
+  // A new vblank restarts the count, even if Clay3DS_ResetVertexBudget is never called.
+  mock_frameCounter++;
+  DrawRects(&rounded, 1);
+  stats = Clay3DS_GetVertexStats();
+  CHECK(stats.usedObjects == ROUNDED_OBJECTS, "%u objects used after a new frame", stats.usedObjects);
+  CHECK(stats.peakObjects == peak, "the peak changed to %u", stats.peakObjects);
+
+  // Over budget, the rounded rectangles are drawn without the corners while a plain rectangle fits, and are then
+  // rejected along with every other draw.
+  Clay3DS_SetVertexBudget(ROUNDED_OBJECTS + 2);
+  mock_frameCounter++;
+  Mock_Reset();
+  DrawRects(&rounded, 2);
+  stats = Clay3DS_GetVertexStats();
+  CHECK(mock_counters.triangles == Clay3DSi__RECT_TRIANGLES + 2 && mock_counters.rects == 1, "%u triangles, %u rectangles",
+        mock_counters.triangles, mock_counters.rects);
+  CHECK(stats.degraded == 1 && stats.dropped == 1, "%u degraded, %u dropped", stats.degraded, stats.dropped);
+
+  DrawRects(&plain, 4);
+  stats = Clay3DS_GetVertexStats();
+  CHECK(stats.usedObjects <= stats.maxObjects, "%u objects used over a budget of %u", stats.usedObjects, stats.maxObjects);
+  CHECK(stats.dropped > 1, "the plain rectangles never overflowed the budget");
+
+  u32 dropped = stats.dropped;
+  DrawRects(&rounded, 1);
+  stats = Clay3DS_GetVertexStats();
+  CHECK(stats.dropped == dropped + 2 && stats.degraded == 1, "%u dropped, %u degraded in a full buffer", stats.dropped,
+        stats.degraded);
+
+  // The next frame has the whole budget again.
+  mock_frameCounter++;
+  Mock_Reset();
+  DrawRects(&rounded, 1);
+  CHECK(mock_counters.triangles == Clay3DSi__RECT_TRIANGLES, "%u triangles in a new frame", mock_counters.triangles);
+
+  // Once the application resets the budget itself, the vblank counter is ignored.
+  Clay3DS_ResetVertexBudget();
+  DrawRects(&rounded, 1);
+  mock_frameCounter++;
+  Mock_Reset();
+  DrawRects(&rounded, 1);
+  stats = Clay3DS_GetVertexStats();
+  CHECK(mock_counters.triangles == 2 && mock_counters.rects == 1, "the explicit frame was restarted by the vblank counter");
+
+  Clay3DS_ResetVertexBudget();
+  Mock_Reset();
+  DrawRects(&rounded, 1);
+  CHECK(mock_counters.triangles == Clay3DSi__RECT_TRIANGLES, "%u triangles after a reset", mock_counters.triangles);
+
+  return TEST_RESULT();
+}